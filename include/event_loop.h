@@ -0,0 +1,62 @@
+/**
+ * Цикл событий с приоритетами поверх очередей из spsc_queue.h.
+ *
+ * Источник событий - пара функций: pending() (в очереди есть событие) и handle() (забрать и обработать одно событие).
+ * Источники передаются в порядке приоритета. После каждого обработанного события проверка начинается снова
+ * с самого приоритетного источника, поэтому длинная очередь низкого приоритета не задерживает срочные события
+ * больше, чем на обработку одного события.
+ *
+ * Когда все очереди пусты, микроконтроллер засыпает в режиме Idle до следующего прерывания.
+ * Очереди проверяются повторно при запрещенных прерываниях: sei перед sleep выполняет еще одну инструкцию
+ * (sleep) до входа в обработчик, поэтому событие, пришедшее после проверки, разбудит цикл, а не потеряется до
+ * следующего прерывания.
+ *
+ * Работает и в сборке на компьютере (hal.h): event_loop_run() выходит, когда hal_running() вернет false,
+ * а сон - шаг модели.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    bool (*pending)(void);
+    void (*handle)(void);
+} event_source_t;
+
+// Обрабатывает одно событие самого приоритетного непустого источника. false - все источники пусты.
+static inline bool event_loop_step(const event_source_t *sources, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (sources[i].pending()) {
+            sources[i].handle();
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline void event_loop_run(const event_source_t *sources, uint8_t count) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (hal_running()) {
+        while (event_loop_step(sources, count)) {
+        }
+
+        cli();
+        bool pending = false;
+        for (uint8_t i = 0; i < count; i++) {
+            pending |= sources[i].pending();
+        }
+        if (!pending) {
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+}
+
+#endif // EVENT_LOOP_H
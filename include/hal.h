@@ -0,0 +1,34 @@
+/**
+ * Доступ к аппаратуре (регистры, прерывания) для AVR и для сборки на компьютере (окружения native-*).
+ *
+ * На AVR подключаются обычные заголовки avr-libc: PORTB, TCCR1B, ISR() и т.д. остаются теми же макросами,
+ * поэтому код компилируется в те же инструкции (sbi/cbi/out), что и без hal.h.
+ *
+ * На компьютере (platform = native) регистры - это переменные, а таймеры, захват (ICP1) и внешние прерывания
+ * моделирует библиотека lib/hal_native. Основной цикл примера пишется как `while (hal_running())`:
+ * на AVR hal_running() - это константа 1, на компьютере - шаг модели (время, таймеры, прерывания).
+ * hal_delay_us(us) - задержка на константу us: на AVR - _delay_us(), на компьютере - продвижение времени модели.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef __AVR__
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/delay.h>
+
+#define hal_running() 1
+#define hal_delay_us(us) _delay_us(us)
+
+#else
+
+#include "hal_native.h"
+
+#define hal_delay_us(us) hal_native_advance((uint32_t)((us) * (F_CPU / 1000000)))
+
+#endif
+
+#endif // HAL_H
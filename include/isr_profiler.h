@@ -0,0 +1,115 @@
+/**
+ * Профилировщик обработчиков прерываний: задержка входа (latency) и длительность (duration).
+ *
+ * Включается флагом ISR_PROFILER (build_flags = -D ISR_PROFILER). Без флага ISR_PROFILED() превращается
+ * в обычный ISR(), а остальные макросы - в пустые выражения: в прошивку не попадает ни одной инструкции.
+ *
+ * Использование:
+ *
+ *  #include "isr_profiler.h"
+ *
+ *  ISR_PROFILED(TIMER1_COMPA_vect, 0, OCR1A) { ... } // Вместо ISR(TIMER1_COMPA_vect) { ... }
+ *  ISR_PROFILED(TIMER1_CAPT_vect, 1, ICR1) { ... }   // Момент события - захваченное значение
+ *  ISR_PROFILED_NO_LATENCY(INT0_vect, 2) { ... }     // Момент события неизвестен, только длительность
+ *
+ * Время измеряется по TCNT1 (Timer1 должен быть запущен, единица измерения - тик Timer1).
+ * - latency  = TCNT1 при входе в тело обработчика - запланированное значение (OCR1A, ICR1 ...).
+ *   Включает аппаратную задержку (4+ тактов), ожидание завершения других прерываний и пролог обработчика (push регистров).
+ * - duration = TCNT1 при выходе из тела - TCNT1 при входе в тело (без пролога и эпилога).
+ *
+ * Для каждого обработчика (номер 0..ISR_PROFILER_VECTORS-1) накапливаются гистограммы с логарифмическими корзинами:
+ * корзина 0 - значение 0, корзина n - значения от 2^(n-1) до 2^n - 1 (корзина 16 - от 32768).
+ * Стоимость записи: ~60-80 тактов на вызов обработчика (две выборки TCNT1, два поиска корзины, счетчики).
+ */
+
+#ifndef ISR_PROFILER_H
+#define ISR_PROFILER_H
+
+#ifdef ISR_PROFILER
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef ISR_PROFILER_VECTORS
+#define ISR_PROFILER_VECTORS 4
+#endif
+
+#define ISR_PROFILER_BUCKETS 17
+
+typedef struct {
+    uint16_t count;
+    uint16_t latency_max;
+    uint16_t duration_max;
+    uint16_t latency[ISR_PROFILER_BUCKETS];
+    uint16_t duration[ISR_PROFILER_BUCKETS];
+} isr_profile_t;
+
+isr_profile_t isr_profiles[ISR_PROFILER_VECTORS];
+
+// Номер корзины: количество значащих бит в value (двоичный поиск, без циклов)
+static inline uint8_t isr_profile_bucket(uint16_t value) {
+    uint8_t bucket = 0;
+    if (value >> 8) { bucket += 8; value >>= 8; }
+    if (value >> 4) { bucket += 4; value >>= 4; }
+    if (value >> 2) { bucket += 2; value >>= 2; }
+    if (value >> 1) { bucket += 1; value >>= 1; }
+    return bucket + value;
+}
+
+static inline void isr_profile_add(uint16_t *histogram, uint16_t *max, uint16_t value) {
+    uint16_t *counter = &histogram[isr_profile_bucket(value)];
+    if (*counter != UINT16_MAX) {
+        (*counter)++; // Насыщение вместо переполнения
+    }
+    if (value > *max) {
+        *max = value;
+    }
+}
+
+static inline void isr_profile_enter(uint8_t id, uint16_t entry, uint16_t scheduled, uint8_t has_latency) {
+    isr_profile_t *profile = &isr_profiles[id];
+    if (profile->count != UINT16_MAX) {
+        profile->count++;
+    }
+    if (has_latency) {
+        isr_profile_add(profile->latency, &profile->latency_max, entry - scheduled);
+    }
+}
+
+static inline void isr_profile_exit(uint8_t id, uint16_t entry) {
+    isr_profile_t *profile = &isr_profiles[id];
+    isr_profile_add(profile->duration, &profile->duration_max, TCNT1 - entry);
+}
+
+// Копирует накопленные данные обработчика и обнуляет их
+static inline void isr_profile_take(uint8_t id, isr_profile_t *result) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *result = isr_profiles[id];
+        memset(&isr_profiles[id], 0, sizeof(isr_profile_t));
+    }
+}
+
+#define ISR_PROFILED_IMPL(vector, id, scheduled, has_latency) \
+    static inline void vector##_profiled_body(void) __attribute__((always_inline)); \
+    ISR(vector) { \
+        uint16_t isr_profile_entry = TCNT1; \
+        isr_profile_enter((id), isr_profile_entry, (scheduled), (has_latency)); \
+        vector##_profiled_body(); \
+        isr_profile_exit((id), isr_profile_entry); \
+    } \
+    static inline void vector##_profiled_body(void)
+
+#define ISR_PROFILED(vector, id, scheduled) ISR_PROFILED_IMPL(vector, id, scheduled, 1)
+#define ISR_PROFILED_NO_LATENCY(vector, id) ISR_PROFILED_IMPL(vector, id, 0, 0)
+
+#else // ISR_PROFILER
+
+#define ISR_PROFILED(vector, id, scheduled) ISR(vector)
+#define ISR_PROFILED_NO_LATENCY(vector, id) ISR(vector)
+
+#endif // ISR_PROFILER
+
+#endif // ISR_PROFILER_H
@@ -0,0 +1,128 @@
+/**
+ * Менеджер питания периферии через регистр PRR (Power Reduction Register).
+ *
+ * Каждый модуль периферии (ADC, таймеры, TWI, SPI, USART) тактируется и потребляет ток,
+ * даже если программа им не пользуется. Бит модуля в PRR отключает его тактирование.
+ * Пока бит в PRR установлен, регистры модуля недоступны (чтение вернет 0, запись игнорируется).
+ *
+ * Менеджер хранит счетчик ссылок для каждого модуля:
+ * - pm_acquire(PM_ADC) - модуль нужен (первый вызов включает тактирование модуля);
+ * - pm_release(PM_ADC) - модуль больше не нужен (последний вызов отключает тактирование модуля).
+ * Драйверы вызывают их сами: twi_init()/twi_shutdown() (twi_master.h), передача кадра в main-shift-register.c,
+ * usart_init() в main-usart.c, запуск журнала в main-adc-logger.c. Программа вызывает pm_acquire() только
+ * для модулей, с которыми работает напрямую.
+ *
+ * pm_init() отключает все модули. Без pm_init() PRR = 0: все модули включены, pm_acquire() ничего не меняет,
+ * а pm_release() после своего pm_acquire() отключит модуль - программа без pm_init() должна захватывать
+ * модули, которыми пользуется сама, так же, как с ним.
+ *
+ * Перед сном pm_sleep() выбирает самый глубокий режим сна, в котором продолжат работать все занятые модули:
+ * - Timer0, Timer1, SPI, USART0, TWI (ведущий) тактируются от clkIO - доступен только Idle;
+ * - ADC работает в режиме ADC Noise Reduction (clkIO остановлен, clkADC работает);
+ * - Timer2 в асинхронном режиме (AS2=1, часовой кварц 32768 Гц) работает в режиме Power-save;
+ * - если ничего не занято - Power-down (с отключением BOD на время сна).
+ * Выбор с учетом допустимой задержки пробуждения - sleep_bounded() в sleep_latency.h.
+ *
+ * Заголовок определяет счетчики ссылок и подключается в один файл программы. Работает и в сборке на компьютере
+ * (hal.h): PRR там только хранит значение.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include "hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    PM_ADC,
+    PM_USART0,
+    PM_SPI,
+    PM_TIMER1,
+    PM_TIMER0,
+    PM_TIMER2,
+    PM_TWI,
+    PM_COUNT,
+} pm_peripheral_t;
+
+// Бит в регистре PRR для каждого модуля (в порядке pm_peripheral_t)
+static const uint8_t PM_PRR_BITS[PM_COUNT] = {
+    (1<<PRADC),
+    (1<<PRUSART0),
+    (1<<PRSPI),
+    (1<<PRTIM1),
+    (1<<PRTIM0),
+    (1<<PRTIM2),
+    (1<<PRTWI),
+};
+
+// Модули, которым для работы нужен clkIO (с ними доступен только режим Idle)
+#define PM_IO_CLOCK_MASK ((1<<PRUSART0) | (1<<PRSPI) | (1<<PRTIM1) | (1<<PRTIM0) | (1<<PRTWI))
+
+uint8_t pm_refcount[PM_COUNT];
+
+// Отключает тактирование всех модулей. Вызывается один раз при старте программы.
+static inline void pm_init(void) {
+    ADCSRA &= ~(1<<ADEN); // ADC нужно выключить до установки PRADC, иначе он останется включенным
+    ACSR |= (1<<ACD); // Аналоговый компаратор не управляется PRR, выключаем его отдельно
+    PRR = (1<<PRADC) | (1<<PRUSART0) | (1<<PRSPI) | (1<<PRTIM1) | (1<<PRTIM0) | (1<<PRTIM2) | (1<<PRTWI);
+}
+
+// Можно вызывать и из прерывания: прерывания запрещаются только на время изменения счетчика и PRR
+static inline void pm_acquire(pm_peripheral_t peripheral) {
+    uint8_t sreg = SREG;
+    cli();
+    if (pm_refcount[peripheral]++ == 0) {
+        PRR &= ~PM_PRR_BITS[peripheral]; // Включаем тактирование модуля
+    }
+    SREG = sreg;
+}
+
+static inline void pm_release(pm_peripheral_t peripheral) {
+    uint8_t sreg = SREG;
+    cli();
+    if (pm_refcount[peripheral] > 0 && --pm_refcount[peripheral] == 0) {
+        if (peripheral == PM_ADC) {
+            ADCSRA &= ~(1<<ADEN); // Выключаем ADC до отключения его тактирования
+        }
+        PRR |= PM_PRR_BITS[peripheral]; // Отключаем тактирование модуля
+    }
+    SREG = sreg;
+}
+
+// Самый глубокий режим сна, в котором продолжат работать все занятые модули.
+static inline uint8_t pm_sleep_mode(void) {
+    uint8_t active = ~PRR; // Бит 1 - модуль тактируется
+
+    if (active & PM_IO_CLOCK_MASK) {
+        return SLEEP_MODE_IDLE;
+    }
+    if ((active & (1<<PRTIM2)) && !(ASSR & (1<<AS2))) {
+        return SLEEP_MODE_IDLE; // Timer2 в синхронном режиме тактируется от clkIO
+    }
+    if (active & (1<<PRADC)) {
+        return SLEEP_MODE_ADC; // Timer2 (асинхронный) продолжит работать и в этом режиме
+    }
+    if (active & (1<<PRTIM2)) {
+        return SLEEP_MODE_PWR_SAVE;
+    }
+    return SLEEP_MODE_PWR_DOWN;
+}
+
+// Засыпает в самом глубоком допустимом режиме и возвращается после обработки прерывания.
+static inline void pm_sleep(void) {
+    uint8_t mode = pm_sleep_mode();
+
+    set_sleep_mode(mode);
+    cli();
+    sleep_enable();
+    if (mode == SLEEP_MODE_PWR_DOWN || mode == SLEEP_MODE_PWR_SAVE) {
+        // BOD отключается только на время ближайшего сна и только если sleep_cpu() выполнен в течение 3 тактов
+        sleep_bod_disable();
+    }
+    sei(); // Инструкция после sei() выполняется до обработки прерываний, поэтому прерывание не потеряется
+    sleep_cpu();
+    sleep_disable();
+}
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,196 @@
+/**
+ * Протопотоки (protothreads): кооперативная многозадачность без стека и без _delay_ms().
+ *
+ * Поток - обычная функция, которая возвращает управление при каждом ожидании и продолжается с того же места
+ * при следующем вызове. Место продолжения хранится в pt_t как адрес метки (расширение GCC "labels as values"),
+ * поэтому состояние потока - 4 байта: адрес продолжения (2 байта) и время пробуждения (2 байта).
+ * Локальные переменные между ожиданиями не сохраняются - их нужно объявлять static или хранить в структуре потока.
+ *
+ *  PT_THREAD(blink(pt_t *pt)) {
+ *      PT_BEGIN(pt);
+ *      while (1) {
+ *          PORTB ^= (1<<PB5);
+ *          PT_AWAIT_MS(pt, 1000);
+ *      }
+ *      PT_END(pt);
+ *  }
+ *
+ * Ожидания:
+ *  PT_AWAIT_MS(pt, ms)                  - задержка до 32767 мс (системный тик 1 мс, Timer0 в режиме CTC);
+ *  PT_AWAIT_EVENT(pt, mask)             - событие, поднятое pt_signal(mask) (обычно из обработчика прерывания);
+ *  PT_AWAIT_ADC(pt, channel, result)    - преобразование АЦП по прерыванию, результат в *result;
+ *  PT_WAIT_UNTIL(pt, condition)         - произвольное условие.
+ *
+ * Планировщик pt_run() вызывает потоки по кругу. Если за проход ни одно прерывание не подняло флаг pt_wakeup,
+ * микроконтроллер засыпает (Idle: Timer0 и АЦП продолжают работать) до следующего прерывания.
+ *
+ * Заголовок занимает Timer0 (TIMER0_COMPA_vect) и АЦП (ADC_vect) и подключается в один файл программы.
+ */
+
+#ifndef PT_H
+#define PT_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    void *resume; // Адрес продолжения, NULL - с начала
+    uint16_t wake_ms; // Время окончания PT_AWAIT_MS
+} pt_t;
+
+typedef enum {
+    PT_WAITING,
+    PT_ENDED,
+} pt_state_t;
+
+typedef pt_state_t (*pt_func_t)(pt_t *pt);
+
+#define PT_THREAD(declaration) pt_state_t declaration
+
+#define PT_CONCAT2(a, b) a ## b
+#define PT_CONCAT(a, b) PT_CONCAT2(a, b)
+#define PT_LABEL PT_CONCAT(pt_resume_, __COUNTER__) // Уникальная метка, даже если макрос ожидания раскрыт дважды в одной строке
+
+#define PT_INIT(pt) ((pt)->resume = NULL)
+
+#define PT_BEGIN(pt) do { if ((pt)->resume) goto *(pt)->resume; } while (0)
+
+#define PT_END(pt) do { (pt)->resume = NULL; return PT_ENDED; } while (0)
+
+#define PT_WAIT_UNTIL(pt, condition) PT_WAIT_UNTIL_AT(pt, condition, PT_LABEL)
+#define PT_WAIT_UNTIL_AT(pt, condition, label) do { \
+    label: \
+    if (!(condition)) { \
+        (pt)->resume = &&label; \
+        return PT_WAITING; \
+    } \
+} while (0)
+
+#define PT_YIELD(pt) PT_YIELD_AT(pt, PT_LABEL)
+#define PT_YIELD_AT(pt, label) do { \
+    (pt)->resume = &&label; \
+    return PT_WAITING; \
+    label:; \
+} while (0)
+
+// --- Время ---
+
+volatile uint16_t pt_now_ms;
+volatile bool pt_wakeup;
+
+ISR(TIMER0_COMPA_vect) {
+    pt_now_ms++;
+    pt_wakeup = true;
+}
+
+static inline uint16_t pt_now(void) {
+    uint16_t now;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        now = pt_now_ms;
+    }
+    return now;
+}
+
+// Разность по модулю 2^16: верно при переполнении счетчика, если задержка меньше 32768 мс
+#define PT_AWAIT_MS(pt, ms) do { \
+    (pt)->wake_ms = pt_now() + (ms); \
+    PT_WAIT_UNTIL(pt, (int16_t)(pt_now() - (pt)->wake_ms) >= 0); \
+} while (0)
+
+// --- События ---
+
+volatile uint8_t pt_events; // До 8 событий, у каждого события один ожидающий поток
+
+// Вызывается из обработчика прерывания (или из потока)
+static inline void pt_signal(uint8_t mask) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pt_events |= mask;
+        pt_wakeup = true;
+    }
+}
+
+// Проверяет и сбрасывает событие
+static inline bool pt_take_event(uint8_t mask) {
+    bool raised;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        raised = pt_events & mask;
+        pt_events &= ~mask;
+    }
+    return raised;
+}
+
+#define PT_AWAIT_EVENT(pt, mask) PT_WAIT_UNTIL(pt, pt_take_event(mask))
+
+// --- АЦП ---
+
+#define PT_EVENT_ADC (1<<7) // Зарезервировано за PT_AWAIT_ADC
+
+volatile bool pt_adc_busy;
+volatile uint16_t pt_adc_result;
+
+ISR(ADC_vect) {
+    pt_adc_result = ADC;
+    pt_events |= PT_EVENT_ADC;
+    pt_wakeup = true;
+}
+
+static inline void pt_adc_start(uint8_t channel) {
+    pt_adc_busy = true;
+    ADMUX = (ADMUX & 0xF0) | (channel & 0x0F);
+    ADCSRA |= (1<<ADSC);
+}
+
+// АЦП один на всех: поток ждет, пока другой поток заберет свой результат и освободит АЦП
+#define PT_AWAIT_ADC(pt, channel, result) do { \
+    PT_WAIT_UNTIL(pt, !pt_adc_busy); \
+    pt_adc_start(channel); \
+    PT_AWAIT_EVENT(pt, PT_EVENT_ADC); \
+    *(result) = pt_adc_result; \
+    pt_adc_busy = false; \
+} while (0)
+
+// --- Планировщик ---
+
+// Timer0 - тик 1 мс, АЦП - опорное AVcc, делитель 128 (125 kHz), прерывание по завершении
+static inline void pt_init(void) {
+    TCCR0A = (1<<WGM01); // CTC
+    OCR0A = 249; // 250 тиков по 4 us = 1 ms
+    TIMSK0 |= (1<<OCIE0A);
+    TCCR0B = (1<<CS01) | (1<<CS00); // Предделитель 64
+
+    ADMUX = (1<<REFS0);
+    ADCSRA = (1<<ADEN) | (1<<ADIE) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0);
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sei();
+}
+
+// Выполняет потоки (не больше 16), пока не завершатся все. Завершенный поток больше не вызывается.
+static inline void pt_run(pt_t *threads, const pt_func_t *funcs, uint8_t count) {
+    uint16_t active = (1UL << count) - 1;
+    while (active) {
+        pt_wakeup = false;
+        for (uint8_t i = 0; i < count; i++) {
+            if ((active & (1U << i)) && funcs[i](&threads[i]) == PT_ENDED) {
+                active &= ~(1U << i);
+            }
+        }
+        // Флаг проверяется при запрещенных прерываниях: sei перед sleep выполнит еще одну инструкцию
+        // (sleep) до входа в обработчик, поэтому прерывание после проверки не будет потеряно
+        cli();
+        if (!pt_wakeup) {
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+}
+
+#endif // PT_H
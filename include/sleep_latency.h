@@ -0,0 +1,133 @@
+/**
+ * Выбор режима сна по допустимой задержке пробуждения.
+ *
+ * Чем глубже сон, тем позже после события выполняется первая инструкция обработчика:
+ *  - Idle, ADC Noise Reduction - генератор работает: 4 такта остановки после пробуждения и 4 такта
+ *    на вход в прерывание (~0.5 us);
+ *  - Standby - кварцевый генератор работает, остановлено только тактирование: +6 тактов;
+ *  - Power-save, Power-down - генератор остановлен и запускается заново: время запуска из фьюзов SUT/CKSEL.
+ *    У Arduino Nano (low fuse 0xFF, кварц, SUT=11) это 16K тактов - 1 ms на 16 MHz;
+ *  - Power-down с отключенным на время сна BOD (sleep_bod_disable()) - еще ~60 us, пока BOD включится.
+ * Задержка в 1 ms ломает все, что измеряет время от первого фронта: ИК-приемник (main-ir-receiver.c)
+ * пропустит начало посылки, если уснет в Power-down между посылками.
+ *
+ * sleep_bounded(max_latency_us) засыпает в самом глубоком режиме из sleep_levels, задержка которого
+ * не больше max_latency_us. sleep_levels[].latency_cycles заполнены по документации (SLEEP_STARTUP_CK - для
+ * других фьюзов), программа может заменить их измеренными (src/main-wake-latency.c).
+ *
+ * Задержка - не единственное ограничение: в глубоких режимах остановлены таймеры на clkIO, USART, SPI.
+ * Поэтому уровень выбирается и по захваченным модулям (power_manager.h): не глубже pm_sleep_mode(),
+ * а при занятом Timer2 (Power-save) Standby пропускается - в нем асинхронный Timer2 стоит.
+ * Прерывания INT0/INT1 по фронту будят только из Idle и ADC Noise Reduction (по низкому уровню - из любого).
+ *
+ * Заголовок определяет таблицу sleep_levels и подключается в один файл программы.
+ */
+
+#ifndef SLEEP_LATENCY_H
+#define SLEEP_LATENCY_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "power_manager.h"
+
+#ifndef SLEEP_STARTUP_CK
+#define SLEEP_STARTUP_CK 16384UL // Запуск генератора из Power-down/Power-save (фьюзы SUT/CKSEL)
+#endif
+#define SLEEP_WAKE_CYCLES 8 // Остановка после пробуждения и вход в прерывание
+#define SLEEP_STANDBY_CK 6
+#define SLEEP_BOD_US 60 // Включение BOD после сна с sleep_bod_disable()
+
+#define SLEEP_US_TO_CYCLES(us) ((uint32_t)(us) * (F_CPU / 1000000))
+
+// Уровни от самого глубокого к самому быстрому
+typedef enum {
+    SLEEP_LEVEL_PWR_DOWN_BOD_OFF,
+    SLEEP_LEVEL_PWR_DOWN,
+    SLEEP_LEVEL_PWR_SAVE,
+    SLEEP_LEVEL_STANDBY,
+    SLEEP_LEVEL_ADC,
+    SLEEP_LEVEL_IDLE,
+    SLEEP_LEVELS,
+} sleep_level_index_t;
+
+typedef struct {
+    uint8_t mode; // SLEEP_MODE_*
+    bool bod_off; // Отключать BOD на время сна
+    uint16_t latency_cycles; // От события до первой инструкции обработчика
+} sleep_level_t;
+
+sleep_level_t sleep_levels[SLEEP_LEVELS] = {
+    [SLEEP_LEVEL_PWR_DOWN_BOD_OFF] = {
+        SLEEP_MODE_PWR_DOWN, true, SLEEP_STARTUP_CK + SLEEP_US_TO_CYCLES(SLEEP_BOD_US) + SLEEP_WAKE_CYCLES,
+    },
+    [SLEEP_LEVEL_PWR_DOWN] = {SLEEP_MODE_PWR_DOWN, false, SLEEP_STARTUP_CK + SLEEP_WAKE_CYCLES},
+    // Задержка как у Power-down, но Timer2 в асинхронном режиме работает: выбирается, только если
+    // Power-down задан большим latency_cycles
+    [SLEEP_LEVEL_PWR_SAVE] = {SLEEP_MODE_PWR_SAVE, false, SLEEP_STARTUP_CK + SLEEP_WAKE_CYCLES},
+    [SLEEP_LEVEL_STANDBY] = {SLEEP_MODE_STANDBY, false, SLEEP_STANDBY_CK + SLEEP_WAKE_CYCLES},
+    [SLEEP_LEVEL_ADC] = {SLEEP_MODE_ADC, false, SLEEP_WAKE_CYCLES},
+    [SLEEP_LEVEL_IDLE] = {SLEEP_MODE_IDLE, false, SLEEP_WAKE_CYCLES},
+};
+
+// Работают ли на уровне level все модули, захваченные у менеджера питания
+static inline bool sleep_level_allowed(sleep_level_index_t level) {
+    switch (pm_sleep_mode()) {
+        case SLEEP_MODE_PWR_DOWN:
+            return true;
+        case SLEEP_MODE_PWR_SAVE: // Асинхронный Timer2
+            return level == SLEEP_LEVEL_PWR_SAVE || level == SLEEP_LEVEL_ADC || level == SLEEP_LEVEL_IDLE;
+        case SLEEP_MODE_ADC:
+            return level == SLEEP_LEVEL_ADC || level == SLEEP_LEVEL_IDLE;
+        default:
+            return level == SLEEP_LEVEL_IDLE;
+    }
+}
+
+static inline sleep_level_index_t sleep_level_search(uint16_t max_latency_us, bool check_modules) {
+    uint32_t max_cycles = SLEEP_US_TO_CYCLES(max_latency_us);
+    for (uint8_t i = 0; i < SLEEP_LEVEL_IDLE; i++) {
+        if (sleep_levels[i].latency_cycles <= max_cycles && (!check_modules || sleep_level_allowed(i))) {
+            return i;
+        }
+    }
+    return SLEEP_LEVEL_IDLE;
+}
+
+// Самый глубокий уровень с задержкой не больше max_latency_us, в котором работают захваченные модули
+// (Idle - всегда)
+static inline sleep_level_index_t sleep_level_for(uint16_t max_latency_us) {
+    return sleep_level_search(max_latency_us, true);
+}
+
+// То же только по задержке, без учета захваченных модулей
+static inline sleep_level_index_t sleep_level_for_latency(uint16_t max_latency_us) {
+    return sleep_level_search(max_latency_us, false);
+}
+
+// Засыпает на уровне level и возвращается после обработки прерывания
+static inline void sleep_at(sleep_level_index_t level) {
+    set_sleep_mode(sleep_levels[level].mode);
+    cli();
+    sleep_enable();
+    if (sleep_levels[level].bod_off) {
+        // BOD отключается только на время ближайшего сна и только если sleep_cpu() выполнен в течение 3 тактов
+        sleep_bod_disable();
+    }
+    sei(); // Инструкция после sei() выполняется до обработки прерываний, поэтому прерывание не потеряется
+    sleep_cpu();
+    sleep_disable();
+}
+
+// Засыпает в самом глубоком режиме, из которого обработчик начнется не позже max_latency_us после события.
+// Возвращает выбранный уровень.
+static inline sleep_level_index_t sleep_bounded(uint16_t max_latency_us) {
+    sleep_level_index_t level = sleep_level_for(max_latency_us);
+    sleep_at(level);
+    return level;
+}
+
+#endif // SLEEP_LATENCY_H
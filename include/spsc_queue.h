@@ -0,0 +1,62 @@
+/**
+ * Очередь без блокировок для одного писателя и одного читателя (SPSC), например: прерывание -> main.
+ *
+ * SPSC_QUEUE(name, type, size) объявляет очередь name и функции:
+ *  bool name_push(type item)   - писатель (обычно обработчик прерывания), false - очередь полна, событие потеряно;
+ *  bool name_pop(type *item)   - читатель, false - очередь пуста;
+ *  bool name_empty(void)       - читатель;
+ *  name.dropped                - сколько событий не поместилось (пишет только писатель).
+ *
+ * size - степень двойки от 2 до 256, в очереди помещается size - 1 элементов. Индексы 8-битные, поэтому чтение
+ * индекса другой стороны атомарно и cli() не нужен: head меняет только писатель, tail - только читатель.
+ * Писатель сначала копирует элемент, затем публикует head; читатель читает элемент только после head и освобождает
+ * место, сдвигая tail, только после копирования. Барьеры компилятора не дают переставить эти обращения.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SPSC_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+#define SPSC_QUEUE(name, type, size) \
+    _Static_assert((size) >= 2 && (size) <= 256 && ((size) & ((size) - 1)) == 0, \
+                   #name ": размер очереди - степень двойки от 2 до 256"); \
+    static struct { \
+        type items[size]; \
+        volatile uint8_t head; \
+        volatile uint8_t tail; \
+        volatile uint8_t dropped; \
+    } name; \
+    static inline bool name##_push(type item) { \
+        uint8_t head = name.head; \
+        uint8_t next = (head + 1) & ((size) - 1); \
+        if (next == name.tail) { \
+            if (name.dropped != 0xFF) { \
+                name.dropped++; \
+            } \
+            return false; \
+        } \
+        name.items[head] = item; \
+        SPSC_BARRIER(); \
+        name.head = next; \
+        return true; \
+    } \
+    static inline bool name##_pop(type *item) { \
+        uint8_t tail = name.tail; \
+        if (tail == name.head) { \
+            return false; \
+        } \
+        SPSC_BARRIER(); \
+        *item = name.items[tail]; \
+        SPSC_BARRIER(); \
+        name.tail = (tail + 1) & ((size) - 1); \
+        return true; \
+    } \
+    static inline bool name##_empty(void) { \
+        return name.tail == name.head; \
+    }
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,294 @@
+/**
+ * Ведущий TWI (I2C) на прерываниях: очередь транзакций, обратные вызовы, восстановление шины.
+ *
+ * Опрос TWINT в цикле занимает процессор на все время обмена (байт на 100 kHz - 90 us), и точные по времени
+ * обработчики (декодер ИК в main-ir-receiver.c) ждут. Здесь каждый шаг обмена (START, адрес, байт, STOP)
+ * выполняет TWI_vect, а между шагами процессор свободен: обработчик ~30-50 тактов на байт.
+ *
+ * Транзакция - запись, чтение или запись и затем чтение через повторный START (регистр датчика, адрес EEPROM):
+ *
+ *  static uint8_t reg = 0x00;
+ *  static uint8_t value[2];
+ *  static twi_transaction_t read_temp = {
+ *      .address = 0x48, .write_data = &reg, .write_length = 1, .read_data = value, .read_length = 2,
+ *      .callback = on_temp,
+ *  };
+ *  twi_submit(&read_temp);
+ *
+ * Транзакции выполняются по очереди (include/spsc_queue.h) подряд: после последнего байта обработчик сразу
+ * отправляет повторный START следующей транзакции, STOP - только когда очередь пуста.
+ * По завершении транзакции обработчик записывает status и вызывает callback (в прерывании, коротко).
+ * Структура транзакции и буферы принадлежат вызывающему и не должны меняться, пока status == TWI_PENDING.
+ * twi_submit() вызывается только из основного цикла (очередь с одним писателем).
+ *
+ * Ошибки:
+ *  - нет ACK на адрес или байт - TWI_NACK_ADDRESS, TWI_NACK_DATA, транзакция завершается;
+ *  - потеря арбитража (другой ведущий) - до TWI_RETRIES повторов с START, затем TWI_ARBITRATION_LOST;
+ *  - ошибка шины (START/STOP не вовремя, статус 0x00) - TWI_BUS_ERROR, TWI отпускает шину через TWSTO;
+ *  - зависание: ведомый держит SDA и TWINT больше не поднимается. twi_tick() (вызывать раз в 1 ms) через
+ *    TWI_TIMEOUT_MS без прерываний TWI выключает модуль, выдает до 9 импульсов SCL вручную, пока ведомый
+ *    не отпустит SDA, формирует STOP и включает TWI снова - TWI_TIMEOUT. Это ~100 us в обработчике twi_tick(),
+ *    только при сбое. START следующей транзакции ждет конца предыдущего STOP не дольше TWI_STOP_WAIT_US
+ *    (с запрещенными прерываниями), а если STOP не уходит (шина занята ведомым), START отправит twi_tick(),
+ *    или транзакция завершится по тайм-ауту.
+ *
+ * Частота: twi_init(400000) - Fast mode (TWBR = 12), twi_init(100000) - Standard (TWBR = 72). Для 400 kHz
+ * подтягивающие резисторы SDA/SCL - 2.2K и меньше (встроенные 20-50K подходят только для коротких линий на 100 kHz).
+ * SDA - PC4(A4), SCL - PC5(A5). twi_init() захватывает модуль TWI у менеджера питания (power_manager.h),
+ * twi_shutdown() отпускает его: пока TWI включен, pm_sleep() выбирает не глубже Idle.
+ *
+ * Заголовок занимает TWI_vect и подключается в один файл программы. Работает и в сборке на компьютере (hal.h):
+ * модель TWI и ведомые устройства - в lib/hal_native.
+ */
+
+#ifndef TWI_MASTER_H
+#define TWI_MASTER_H
+
+#include "hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "spsc_queue.h"
+#include "power_manager.h"
+
+#ifndef TWI_QUEUE_SIZE
+#define TWI_QUEUE_SIZE 8
+#endif
+#define TWI_RETRIES 3
+#define TWI_TIMEOUT_MS 10
+#define TWI_STOP_WAIT_US 20 // STOP на 100 kHz уходит за период SCL (10 us)
+
+#define TWI_SDA_PIN PC4
+#define TWI_SCL_PIN PC5
+
+typedef enum {
+    TWI_IDLE, // Еще не ставилась в очередь
+    TWI_PENDING,
+    TWI_OK,
+    TWI_NACK_ADDRESS,
+    TWI_NACK_DATA,
+    TWI_ARBITRATION_LOST,
+    TWI_BUS_ERROR,
+    TWI_TIMEOUT,
+} twi_status_t;
+
+typedef struct twi_transaction twi_transaction_t;
+
+struct twi_transaction {
+    uint8_t address; // 7-битный адрес
+    const uint8_t *write_data;
+    uint8_t write_length; // 0 - без записи
+    uint8_t *read_data;
+    uint8_t read_length; // 0 - без чтения (если и запись 0 - только адрес: проверка наличия устройства)
+    void (*callback)(twi_transaction_t *transaction); // Из прерывания, может быть NULL
+    void *context;
+    volatile twi_status_t status;
+};
+
+SPSC_QUEUE(twi_queue, twi_transaction_t *, TWI_QUEUE_SIZE)
+
+twi_transaction_t *twi_current; // NULL - шина свободна (меняет TWI_vect, а при свободной шине - twi_submit())
+uint8_t twi_position; // Байт внутри записи или чтения
+bool twi_reading;
+uint8_t twi_attempts;
+volatile uint8_t twi_idle_ms; // Миллисекунд без прерывания TWI во время транзакции
+bool twi_start_deferred; // START текущей транзакции ждет конца STOP (отправит twi_tick())
+
+#define TWI_CONTROL ((1<<TWINT) | (1<<TWEN) | (1<<TWIE))
+
+// Статус без битов предделителя
+#define TWI_STATUS() (TWSR & 0xF8)
+
+static inline void twi_start_condition(void) {
+    TWCR = TWI_CONTROL | (1<<TWSTA);
+}
+
+// Берет следующую транзакцию и отправляет START (повторный, если шина еще наша). Прерывания запрещены.
+static inline void twi_start_next(bool bus_owned) {
+    if (!twi_queue_pop(&twi_current)) {
+        twi_current = NULL;
+        if (bus_owned) {
+            TWCR = TWI_CONTROL | (1<<TWSTO);
+        }
+        return;
+    }
+    twi_reading = false;
+    twi_position = 0;
+    twi_attempts = 0;
+    twi_idle_ms = 0;
+    if (!bus_owned) {
+        // Предыдущий STOP еще передается (до одного периода SCL): START, записанный поверх, его отменил бы
+        for (uint8_t us = 0; us < TWI_STOP_WAIT_US && (TWCR & (1<<TWSTO)); us++) {
+            hal_delay_us(1);
+        }
+        if (TWCR & (1<<TWSTO)) {
+            twi_start_deferred = true; // Шина не освободилась: не ждать с запрещенными прерываниями
+            return;
+        }
+    }
+    twi_start_condition();
+}
+
+// Завершает текущую транзакцию и сразу начинает следующую
+static inline void twi_complete(twi_status_t status, bool bus_owned) {
+    twi_transaction_t *transaction = twi_current;
+    transaction->status = status;
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+    twi_start_next(bus_owned);
+}
+
+static inline void twi_send_address(bool read) {
+    twi_reading = read;
+    twi_position = 0;
+    TWDR = (twi_current->address << 1) | (read ? 1 : 0);
+    TWCR = TWI_CONTROL;
+}
+
+// Следующий байт чтения: ACK, если после него будут еще байты
+static inline void twi_read_next(void) {
+    TWCR = TWI_CONTROL | (twi_position + 1 < twi_current->read_length ? (1<<TWEA) : 0);
+}
+
+ISR(TWI_vect) {
+    twi_transaction_t *transaction = twi_current;
+    twi_idle_ms = 0;
+    if (!transaction) {
+        TWCR = TWI_CONTROL; // Прерывание без транзакции (не должно быть): сбросить TWINT, не трогая шину
+        return;
+    }
+
+    switch (TWI_STATUS()) {
+        case 0x08: // START
+        case 0x10: // Повторный START
+            // Чтение - после записи (twi_reading выставлен перед повторным START) или в транзакции без записи
+            twi_send_address(twi_reading || (transaction->write_length == 0 && transaction->read_length != 0));
+            break;
+
+        case 0x18: // SLA+W, ACK
+        case 0x28: // Байт записан, ACK
+            if (twi_position < transaction->write_length) {
+                TWDR = transaction->write_data[twi_position++];
+                TWCR = TWI_CONTROL;
+            } else if (transaction->read_length) {
+                twi_reading = true;
+                twi_start_condition(); // Запись, затем чтение: повторный START
+            } else {
+                twi_complete(TWI_OK, true);
+            }
+            break;
+
+        case 0x40: // SLA+R, ACK
+            twi_read_next();
+            break;
+
+        case 0x50: // Байт прочитан, ACK отправлен
+            transaction->read_data[twi_position++] = TWDR;
+            twi_read_next();
+            break;
+
+        case 0x58: // Последний байт прочитан, NACK отправлен
+            transaction->read_data[twi_position] = TWDR;
+            twi_complete(TWI_OK, true);
+            break;
+
+        case 0x20: // SLA+W, NACK
+        case 0x48: // SLA+R, NACK
+            twi_complete(TWI_NACK_ADDRESS, true);
+            break;
+
+        case 0x30: // Байт записан, NACK
+            twi_complete(TWI_NACK_DATA, true);
+            break;
+
+        case 0x38: // Арбитраж потерян: шину занял другой ведущий, START будет отправлен, когда она освободится
+            if (++twi_attempts <= TWI_RETRIES) {
+                twi_reading = false;
+                twi_position = 0;
+                twi_start_condition();
+            } else {
+                TWCR = TWI_CONTROL; // Отпустить шину
+                twi_complete(TWI_ARBITRATION_LOST, false);
+            }
+            break;
+
+        case 0x00: // Ошибка шины: TWSTO без STOP на шине возвращает модуль в исходное состояние
+        default:
+            TWCR = TWI_CONTROL | (1<<TWSTO);
+            twi_complete(TWI_BUS_ERROR, false);
+            break;
+    }
+}
+
+// Освобождает шину, которую держит ведомый: до 9 импульсов SCL, пока SDA не отпущена, затем STOP.
+// Линии открытый сток: 0 - выход с низким уровнем, 1 - вход (подтяжка внешним резистором).
+static void twi_bus_clear(void) {
+    TWCR = 0;
+    PORTC &= ~((1<<TWI_SDA_PIN) | (1<<TWI_SCL_PIN));
+    DDRC &= ~((1<<TWI_SDA_PIN) | (1<<TWI_SCL_PIN));
+    for (uint8_t i = 0; i < 9 && !(PINC & (1<<TWI_SDA_PIN)); i++) {
+        DDRC |= (1<<TWI_SCL_PIN);
+        hal_delay_us(5);
+        DDRC &= ~(1<<TWI_SCL_PIN);
+        hal_delay_us(5);
+    }
+    // STOP: SDA из низкого в высокий при высоком SCL
+    DDRC |= (1<<TWI_SDA_PIN);
+    hal_delay_us(5);
+    DDRC &= ~(1<<TWI_SDA_PIN);
+    hal_delay_us(5);
+    PORTC |= (1<<TWI_SDA_PIN) | (1<<TWI_SCL_PIN);
+    TWCR = (1<<TWEN) | (1<<TWIE);
+}
+
+// Вызывать раз в 1 ms (из прерывания таймера или основного цикла)
+static inline void twi_tick(void) {
+    uint8_t sreg = SREG;
+    cli();
+    if (twi_current && twi_start_deferred && !(TWCR & (1<<TWSTO))) {
+        twi_start_deferred = false;
+        twi_start_condition();
+    } else if (twi_current && ++twi_idle_ms >= TWI_TIMEOUT_MS) {
+        twi_start_deferred = false;
+        twi_bus_clear(); // TWCR = 0 сбрасывает и TWSTO
+        twi_complete(TWI_TIMEOUT, false);
+    }
+    SREG = sreg;
+}
+
+// Ставит транзакцию в очередь. false - очередь полна, status не меняется.
+static inline bool twi_submit(twi_transaction_t *transaction) {
+    twi_status_t previous = transaction->status;
+    transaction->status = TWI_PENDING; // До push: обработчик может взять транзакцию сразу
+    if (!twi_queue_push(transaction)) {
+        transaction->status = previous; // Не поставлена в очередь: прежний статус
+        return false;
+    }
+    uint8_t sreg = SREG;
+    cli();
+    if (!twi_current) {
+        twi_start_next(false);
+    }
+    SREG = sreg;
+    return true;
+}
+
+// Частота SCL (100 000 или 400 000 Hz). Предделитель TWI = 1: TWBR = (F_CPU / hz - 16) / 2.
+// Включает тактирование TWI (power_manager.h) до twi_shutdown().
+static inline void twi_init(uint32_t hz) {
+    pm_acquire(PM_TWI);
+    TWSR = 0;
+    TWBR = (F_CPU / hz - 16) / 2;
+    PORTC |= (1<<TWI_SDA_PIN) | (1<<TWI_SCL_PIN); // Встроенная подтяжка (вместе с внешними резисторами)
+    TWCR = (1<<TWEN) | (1<<TWIE);
+}
+
+// Выключает TWI и его тактирование. Вызывать, когда транзакций нет (twi_current == NULL и очередь пуста).
+static inline void twi_shutdown(void) {
+    TWCR = 0;
+    pm_release(PM_TWI);
+}
+
+#endif // TWI_MASTER_H
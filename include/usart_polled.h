@@ -0,0 +1,83 @@
+/**
+ * USART0 без прерываний и без буфера - вывод отчетов и дампов в примерах.
+ *
+ * 1 000 000 бод при U2X0=1 (UBRR0 = 1, на 16 MHz без ошибки скорости), 8N1.
+ *
+ * Ожидание выбирается явно, как в main-usart.c:
+ *  bool usart_try_write_byte(data)           - не ждет, false - регистр UDR0 занят, байт не записан;
+ *  int16_t usart_read(void)                  - не ждет, принятый байт или -1;
+ *  usart_write_byte_blocking(data)           - ждет, пока освободится UDR0 (до 10 us на байт);
+ *  usart_write_blocking(data, len), usart_print_blocking(str), usart_print_uint_blocking(value) - ждут на каждом байте;
+ *  usart_flush_blocking()                    - ждет, пока последний байт уйдет из сдвигового регистра.
+ * Функции _blocking останавливают программу на все время передачи: вызывать их там, где это допустимо (отчет после
+ * измерения, дамп по команде). Вывод в фоне, без остановки программы, - буфер на прерываниях из main-usart.c.
+ *
+ * usart_init(rx) включает передатчик и, если rx, приемник. Модуль USART0 у менеджера питания (power_manager.h)
+ * захватывает вызывающий до usart_init().
+ */
+
+#ifndef USART_POLLED_H
+#define USART_POLLED_H
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+static inline void usart_init(bool rx) {
+    UBRR0 = 1; // 1 000 000 бод при U2X0=1
+    UCSR0A = (1<<U2X0);
+    UCSR0C = (1<<UCSZ01) | (1<<UCSZ00); // 8N1
+    UCSR0B = (rx ? (1<<RXEN0) : 0) | (1<<TXEN0);
+}
+
+static inline bool usart_try_write_byte(uint8_t data) {
+    if (!(UCSR0A & (1<<UDRE0))) {
+        return false;
+    }
+    UDR0 = data;
+    return true;
+}
+
+static inline int16_t usart_read(void) {
+    if (!(UCSR0A & (1<<RXC0))) {
+        return -1;
+    }
+    return UDR0;
+}
+
+static inline void usart_write_byte_blocking(uint8_t data) {
+    while (!usart_try_write_byte(data));
+}
+
+static inline void usart_write_blocking(const void *data, uint16_t len) {
+    const uint8_t *bytes = data;
+    while (len--) {
+        usart_write_byte_blocking(*bytes++);
+    }
+}
+
+static inline void usart_print_blocking(const char *str) {
+    while (*str) {
+        usart_write_byte_blocking(*str++);
+    }
+}
+
+static inline void usart_print_uint_blocking(uint32_t value) {
+    char buffer[11];
+    uint8_t i = sizeof(buffer) - 1;
+    buffer[i] = '\0';
+    do {
+        buffer[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    usart_print_blocking(&buffer[i]);
+}
+
+// Перед глубоким сном или отключением модуля: иначе USART остановится посреди байта
+static inline void usart_flush_blocking(void) {
+    UCSR0A |= (1<<TXC0); // Сброс флага записью 1
+    while (!(UCSR0A & (1<<UDRE0)));
+    while (!(UCSR0A & (1<<TXC0)));
+}
+
+#endif
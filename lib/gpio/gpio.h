@@ -0,0 +1,112 @@
+/**
+ * Пины и группы пинов как типы C++ (header-only).
+ *
+ * Порт и номер бита - параметры шаблона, поэтому маска известна при компиляции. Ожидаемый код с -Os
+ * (оценка вручную по набору инструкций AVR, листингом avr-objdump не проверена):
+ *  - Pin<PortB, PB5>::set() / clear()  -> одна инструкция sbi / cbi;
+ *  - Pin<PortB, PB5>::toggle()         -> ldi + out: запись маски в PINB (запись 1 в PINx инвертирует бит PORTx,
+ *                                        0 ничего не меняет), поэтому чтение порта не нужно. Так же PinGroup::toggle();
+ *  - Pin<PortB, PB5>::read()           -> sbis/sbic или in + andi;
+ *  - PinGroup<...>::write(value)       -> один цикл чтение-изменение-запись порта (in, andi, andi, or, out)
+ *    вместо отдельной операции на каждый пин.
+ *
+ * Пример:
+ *   typedef gpio::Pin<gpio::PortB, PB3> LedRed;
+ *   typedef gpio::Pin<gpio::PortB, PB1> LedGreen;
+ *   typedef gpio::PinGroup<LedRed, LedGreen> Leds;
+ *
+ *   Leds::output();
+ *   Leds::write(LedRed::mask); // Красный включен, зеленый выключен
+ *
+ * sbi/cbi и запись в PINx (toggle()) атомарны. write() и set()/clear() группы из нескольких пинов - нет (in, or/and, out):
+ * если тот же порт меняется в обработчике прерывания, вызов нужно обернуть в ATOMIC_BLOCK.
+ * Проверить оценку и сравнить с кодом на C: окружения traffic-light и traffic-light-cpp (avr-objdump -d, tools/simbench).
+ */
+
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+namespace gpio {
+
+#define GPIO_PORT(name, letter) \
+    struct name { \
+        static volatile uint8_t &port() { return PORT##letter; } \
+        static volatile uint8_t &ddr() { return DDR##letter; } \
+        static volatile uint8_t &pin() { return PIN##letter; } \
+    };
+
+GPIO_PORT(PortB, B)
+GPIO_PORT(PortC, C)
+GPIO_PORT(PortD, D)
+
+#undef GPIO_PORT
+
+template <typename Port, uint8_t Bit>
+struct Pin {
+    static_assert(Bit < 8, "Pin: номер бита 0..7");
+
+    typedef Port port_t;
+    static constexpr uint8_t mask = 1 << Bit;
+
+    static void output() { Port::ddr() |= mask; }
+    static void input() { Port::ddr() &= ~mask; }
+    static void pullup() { input(); Port::port() |= mask; }
+
+    static void set() { Port::port() |= mask; }
+    static void clear() { Port::port() &= ~mask; }
+    static void toggle() { Port::pin() = mask; }
+    static void write(bool value) {
+        if (value) {
+            set();
+        } else {
+            clear();
+        }
+    }
+
+    static bool read() { return Port::pin() & mask; }
+};
+
+// --- Группа пинов одного порта ---
+
+template <typename A, typename B>
+struct same_type { static constexpr bool value = false; };
+
+template <typename A>
+struct same_type<A, A> { static constexpr bool value = true; };
+
+template <typename Port, typename... Pins>
+struct port_mask;
+
+template <typename Port>
+struct port_mask<Port> { static constexpr uint8_t value = 0; };
+
+template <typename Port, typename First, typename... Rest>
+struct port_mask<Port, First, Rest...> {
+    static_assert(same_type<typename First::port_t, Port>::value, "PinGroup: все пины должны быть на одном порту");
+    static constexpr uint8_t value = First::mask | port_mask<Port, Rest...>::value;
+};
+
+template <typename First, typename... Rest>
+struct PinGroup {
+    typedef typename First::port_t port_t;
+    static constexpr uint8_t mask = port_mask<port_t, First, Rest...>::value;
+
+    static void output() { port_t::ddr() |= mask; }
+    static void input() { port_t::ddr() &= ~mask; }
+
+    static void set() { port_t::port() |= mask; }
+    static void clear() { port_t::port() &= ~mask; }
+    static void toggle() { port_t::pin() = mask; }
+
+    // value - биты в позициях пинов порта (как в PORTx), биты вне группы не меняются
+    static void write(uint8_t value) { port_t::port() = (port_t::port() & ~mask) | (value & mask); }
+
+    static uint8_t read() { return port_t::pin() & mask; }
+};
+
+} // namespace gpio
+
+#endif // GPIO_H
@@ -0,0 +1,618 @@
+/**
+ * Модель ATmega328P для сборки примеров на компьютере (см. hal_native.h).
+ */
+
+#ifndef __AVR__
+
+#include "hal_native.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+volatile uint8_t SREG, EICRA, EIMSK, PCICR, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1;
+volatile uint16_t EIFR, PCIFR, TIFR0, TIFR1;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+volatile uint8_t TWBR, TWSR = 0xF8, TWAR, TWDR = 0xFF, TWCR;
+volatile uint8_t PRR, ADCSRA, ACSR, ASSR;
+
+// Обработчики по умолчанию (переопределяются ISR() в программе)
+#define HAL_NATIVE_WEAK_VECTOR(name) __attribute__((weak)) void name(void) {}
+
+HAL_NATIVE_WEAK_VECTOR(hal_native_int0)
+HAL_NATIVE_WEAK_VECTOR(hal_native_int1)
+HAL_NATIVE_WEAK_VECTOR(hal_native_pcint0)
+HAL_NATIVE_WEAK_VECTOR(hal_native_pcint1)
+HAL_NATIVE_WEAK_VECTOR(hal_native_pcint2)
+HAL_NATIVE_WEAK_VECTOR(hal_native_timer1_capt)
+HAL_NATIVE_WEAK_VECTOR(hal_native_timer1_compa)
+HAL_NATIVE_WEAK_VECTOR(hal_native_timer1_compb)
+HAL_NATIVE_WEAK_VECTOR(hal_native_timer1_ovf)
+HAL_NATIVE_WEAK_VECTOR(hal_native_timer0_compa)
+HAL_NATIVE_WEAK_VECTOR(hal_native_timer0_compb)
+HAL_NATIVE_WEAK_VECTOR(hal_native_timer0_ovf)
+HAL_NATIVE_WEAK_VECTOR(hal_native_twi)
+
+static void twi_vector(void);
+static void twi_take_request(void);
+
+// --- Флаги прерываний ---
+//
+// EIFR, PCIFR, TIFR0, TIFR1 сбрасываются записью 1, как на AVR. Флаги хранятся в модели (flags), регистр программы
+// - опубликованное значение: младший байт - флаги, старший - FLAGS_MARK. Присваивание стирает метку,
+// и при следующей синхронизации записанные единицы сбрасывают флаги, а регистр публикуется заново.
+
+#define FLAGS_MARK 0xA500
+
+typedef struct {
+    volatile uint16_t *reg;
+    volatile uint8_t flags;
+} flag_register_t;
+
+enum {
+    FLAGS_EIFR,
+    FLAGS_PCIFR,
+    FLAGS_TIFR0,
+    FLAGS_TIFR1,
+    FLAGS_COUNT,
+};
+
+static flag_register_t flag_registers[FLAGS_COUNT] = {
+    [FLAGS_EIFR] = {&EIFR},
+    [FLAGS_PCIFR] = {&PCIFR},
+    [FLAGS_TIFR0] = {&TIFR0},
+    [FLAGS_TIFR1] = {&TIFR1},
+};
+
+// Применяет запись программы (если была) и публикует флаги модели
+static void sync_flag_register(flag_register_t *reg) {
+    uint16_t value = *reg->reg;
+    if ((value & 0xFF00) != FLAGS_MARK) {
+        reg->flags &= ~(uint8_t)value;
+    }
+    *reg->reg = FLAGS_MARK | reg->flags;
+}
+
+static void sync_flags(void) {
+    for (int i = 0; i < FLAGS_COUNT; i++) {
+        sync_flag_register(&flag_registers[i]);
+    }
+}
+
+static void raise_flag(int index, uint8_t bit) {
+    flag_register_t *reg = &flag_registers[index];
+    sync_flag_register(reg); // Запись программы до события применяется первой
+    reg->flags |= (1 << bit);
+    *reg->reg = FLAGS_MARK | reg->flags;
+}
+
+typedef struct {
+    volatile uint8_t *flags;
+    uint8_t flag;
+    volatile uint8_t *mask;
+    uint8_t enable;
+    void (*handler)(void);
+} vector_t;
+
+// В порядке приоритета (номера векторов ATmega328P)
+static const vector_t VECTORS[] = {
+    {&flag_registers[FLAGS_EIFR].flags, INTF0, &EIMSK, INT0, hal_native_int0},
+    {&flag_registers[FLAGS_EIFR].flags, INTF1, &EIMSK, INT1, hal_native_int1},
+    {&flag_registers[FLAGS_PCIFR].flags, PCIF0, &PCICR, PCIE0, hal_native_pcint0},
+    {&flag_registers[FLAGS_PCIFR].flags, PCIF1, &PCICR, PCIE1, hal_native_pcint1},
+    {&flag_registers[FLAGS_PCIFR].flags, PCIF2, &PCICR, PCIE2, hal_native_pcint2},
+    {&flag_registers[FLAGS_TIFR1].flags, ICF1, &TIMSK1, ICIE1, hal_native_timer1_capt},
+    {&flag_registers[FLAGS_TIFR1].flags, OCF1A, &TIMSK1, OCIE1A, hal_native_timer1_compa},
+    {&flag_registers[FLAGS_TIFR1].flags, OCF1B, &TIMSK1, OCIE1B, hal_native_timer1_compb},
+    {&flag_registers[FLAGS_TIFR1].flags, TOV1, &TIMSK1, TOIE1, hal_native_timer1_ovf},
+    {&flag_registers[FLAGS_TIFR0].flags, OCF0A, &TIMSK0, OCIE0A, hal_native_timer0_compa},
+    {&flag_registers[FLAGS_TIFR0].flags, OCF0B, &TIMSK0, OCIE0B, hal_native_timer0_compb},
+    {&flag_registers[FLAGS_TIFR0].flags, TOV0, &TIMSK0, TOIE0, hal_native_timer0_ovf},
+    {&TWCR, TWINT, &TWCR, TWIE, twi_vector},
+};
+
+#define VECTORS_COUNT (sizeof(VECTORS) / sizeof(VECTORS[0]))
+
+typedef struct {
+    uint64_t cycle;
+    char port;
+    uint8_t bit;
+    bool level;
+} stimulus_t;
+
+static uint64_t cycles;
+static uint64_t duration_cycles;
+static uint32_t loop_cycles;
+static bool trace;
+static bool initialized;
+
+static stimulus_t *stimuli;
+static size_t stimuli_count;
+static size_t stimuli_next;
+
+static uint8_t input_level[3]; // Внешний уровень на пинах B, C, D
+static uint8_t input_driven[3]; // Пины, на которые подан внешний сигнал
+static uint8_t last_pin[3];
+static uint8_t last_port[3];
+
+static uint16_t timer0_prescaler_count;
+static uint16_t timer1_prescaler_count;
+
+static const uint16_t PRESCALERS[8] = {0, 1, 8, 64, 256, 1024, 0, 0}; // CS2..0 = 6, 7 - внешний вход T0/T1 (не моделируется)
+
+static int port_index(char port) {
+    return port == 'B' ? 0 : port == 'C' ? 1 : port == 'D' ? 2 : -1;
+}
+
+static volatile uint8_t *pin_register(int index) {
+    return index == 0 ? &PINB : index == 1 ? &PINC : &PIND;
+}
+
+// PINx: выходы читают PORTx, входы - внешний уровень, а без внешнего сигнала - подтяжку (PORTx)
+static void update_pins(void) {
+    const volatile uint8_t *ddr[3] = {&DDRB, &DDRC, &DDRD};
+    const volatile uint8_t *port[3] = {&PORTB, &PORTC, &PORTD};
+    for (int i = 0; i < 3; i++) {
+        uint8_t outputs = *ddr[i];
+        uint8_t driven = input_driven[i] & ~outputs;
+        *pin_register(i) = (*port[i] & ~driven) | (input_level[i] & driven);
+    }
+}
+
+static void on_pin_edges(int index, uint8_t previous, uint8_t current) {
+    uint8_t changed = previous ^ current;
+    if (!changed) {
+        return;
+    }
+
+    static volatile uint8_t *const PCMSK[3] = {&PCMSK0, &PCMSK1, &PCMSK2};
+    if (changed & *PCMSK[index]) {
+        raise_flag(FLAGS_PCIFR, index);
+    }
+
+    if (index == 0 && (changed & (1<<PB0))) { // ICP1
+        bool rising = current & (1<<PB0);
+        if (rising == !!(TCCR1B & (1<<ICES1))) {
+            ICR1 = TCNT1;
+            raise_flag(FLAGS_TIFR1, ICF1);
+        }
+    }
+
+    if (index == 2) { // INT0 - PD2, INT1 - PD3
+        for (uint8_t n = 0; n < 2; n++) {
+            uint8_t bit = 1 << (PD2 + n);
+            if (changed & bit) {
+                uint8_t mode = (EICRA >> (2 * n)) & 0b11; // 00 - низкий уровень (как спад), 01 - любой, 10 - спад, 11 - подъем
+                bool rising = current & bit;
+                if (mode == 0b01 || (mode == 0b11 && rising) || ((mode == 0b10 || mode == 0b00) && !rising)) {
+                    raise_flag(FLAGS_EIFR, n);
+                }
+            }
+        }
+    }
+}
+
+static void update_inputs(void) {
+    update_pins();
+    for (int i = 0; i < 3; i++) {
+        uint8_t current = *pin_register(i);
+        on_pin_edges(i, last_pin[i], current);
+        last_pin[i] = current;
+    }
+}
+
+static void service_interrupts(void) {
+    sync_flags(); // Программа могла сбросить флаги
+    for (size_t i = 0; i < VECTORS_COUNT && (SREG & (1<<SREG_I)); i++) {
+        const vector_t *vector = &VECTORS[i];
+        if ((*vector->flags & (1 << vector->flag)) && (*vector->mask & (1 << vector->enable))) {
+            *vector->flags &= ~(1 << vector->flag); // Флаг сбрасывается аппаратно при входе в обработчик
+            sync_flags();
+            SREG &= ~(1<<SREG_I);
+            vector->handler();
+            SREG |= (1<<SREG_I); // reti
+            sync_flags();
+            twi_take_request(); // Запись TWINT = 1 в обработчике - команда TWI, а не новое прерывание
+            update_inputs();
+            i = (size_t)-1; // Следующим выполняется прерывание с наивысшим приоритетом
+        }
+    }
+}
+
+static void timer0_tick(void) {
+    bool ctc = (TCCR0A & ((1<<WGM01) | (1<<WGM00))) == (1<<WGM01);
+    if (ctc && TCNT0 == OCR0A) {
+        TCNT0 = 0;
+    } else if (++TCNT0 == 0) {
+        raise_flag(FLAGS_TIFR0, TOV0);
+    }
+    if (TCNT0 == OCR0A) {
+        raise_flag(FLAGS_TIFR0, OCF0A);
+    }
+    if (TCNT0 == OCR0B) {
+        raise_flag(FLAGS_TIFR0, OCF0B);
+    }
+}
+
+static void timer1_tick(void) {
+    bool ctc = (TCCR1B & ((1<<WGM13) | (1<<WGM12))) == (1<<WGM12);
+    if (ctc && TCNT1 == OCR1A) {
+        TCNT1 = 0;
+    } else if (++TCNT1 == 0) {
+        raise_flag(FLAGS_TIFR1, TOV1);
+    }
+    if (TCNT1 == OCR1A) {
+        raise_flag(FLAGS_TIFR1, OCF1A);
+    }
+    if (TCNT1 == OCR1B) {
+        raise_flag(FLAGS_TIFR1, OCF1B);
+    }
+}
+
+// --- TWI (ведущий) ---
+//
+// TWINT в TWCR - это и флаг прерывания, и команда: программа записывает 1, чтобы начать следующую операцию.
+// Модель различает их по twi_flag: флаг поднят моделью и еще не взят обработчиком (или программой).
+// Модель выполняет команду (START, STOP, байт адреса или данных) за время на шине и поднимает TWINT
+// со статусом в TWSR, как аппаратура.
+
+#define TWI_SLAVES_MAX 8
+#define TWI_FAULTS_MAX 8
+
+typedef enum {
+    TWI_FAULT_BUS_ERROR,
+    TWI_FAULT_STUCK,
+} twi_fault_kind_t;
+
+typedef struct {
+    uint32_t byte; // Номер байта на шине, с 1
+    twi_fault_kind_t kind;
+} twi_fault_t;
+
+typedef struct {
+    hal_native_twi_slave_t slave;
+    uint8_t data[256];
+    uint8_t pointer;
+    bool pointer_set;
+    bool written; // В этой транзакции записаны данные (не только указатель)
+    uint64_t busy_until; // Цикл записи (как у 24C02): до этого такта адрес не подтверждается
+} twi_memory_t;
+
+#define TWI_MEMORY_WRITE_CYCLES (F_CPU / 1000 * 5) // 5 ms
+
+static hal_native_twi_slave_t *twi_slaves[TWI_SLAVES_MAX];
+static uint8_t twi_slaves_count;
+static twi_memory_t twi_memories[TWI_SLAVES_MAX];
+static twi_fault_t twi_faults[TWI_FAULTS_MAX];
+static uint8_t twi_faults_count;
+
+static bool twi_flag; // TWINT поднят моделью
+static bool twi_busy; // Команда выполняется на шине
+static bool twi_stuck;
+static bool twi_stop_only; // Выполняется STOP без START: TWINT после него не поднимается
+static uint64_t twi_done_cycle;
+static uint8_t twi_status;
+static bool twi_owner; // START отправлен, STOP еще нет
+static bool twi_expect_address;
+static bool twi_reading;
+static hal_native_twi_slave_t *twi_target;
+static uint32_t twi_bytes;
+
+void hal_native_twi_attach(hal_native_twi_slave_t *slave) {
+    if (twi_slaves_count < TWI_SLAVES_MAX) {
+        twi_slaves[twi_slaves_count++] = slave;
+    }
+}
+
+static bool twi_memory_start(hal_native_twi_slave_t *slave, bool read) {
+    twi_memory_t *memory = (twi_memory_t *)slave;
+    if (cycles < memory->busy_until) {
+        return false; // Идет запись: NACK на адрес (на этом основан опрос готовности)
+    }
+    if (!read) {
+        memory->pointer_set = false;
+    }
+    return true;
+}
+
+static bool twi_memory_write(hal_native_twi_slave_t *slave, uint8_t byte) {
+    twi_memory_t *memory = (twi_memory_t *)slave;
+    if (!memory->pointer_set) {
+        memory->pointer = byte;
+        memory->pointer_set = true;
+    } else {
+        memory->data[memory->pointer++] = byte;
+        memory->written = true;
+    }
+    return true;
+}
+
+static void twi_memory_stop(hal_native_twi_slave_t *slave) {
+    twi_memory_t *memory = (twi_memory_t *)slave;
+    if (memory->written) {
+        memory->written = false;
+        memory->busy_until = cycles + TWI_MEMORY_WRITE_CYCLES;
+    }
+}
+
+static uint8_t twi_memory_read(hal_native_twi_slave_t *slave) {
+    twi_memory_t *memory = (twi_memory_t *)slave;
+    return memory->data[memory->pointer++];
+}
+
+static void twi_init(void) {
+    const char *value = getenv("HAL_NATIVE_TWI_MEMORY");
+    for (uint8_t i = 0; value && *value && i < TWI_SLAVES_MAX; i++) {
+        char *end;
+        twi_memory_t *memory = &twi_memories[i];
+        memory->slave = (hal_native_twi_slave_t){
+            .address = (uint8_t)strtoul(value, &end, 0),
+            .start = twi_memory_start,
+            .write = twi_memory_write,
+            .read = twi_memory_read,
+            .stop = twi_memory_stop,
+        };
+        for (int j = 0; j < 256; j++) {
+            memory->data[j] = j;
+        }
+        hal_native_twi_attach(&memory->slave);
+        value = *end == ',' ? end + 1 : NULL;
+    }
+
+    value = getenv("HAL_NATIVE_TWI_FAULT");
+    while (value && *value && twi_faults_count < TWI_FAULTS_MAX) {
+        char kind[16];
+        unsigned byte;
+        if (sscanf(value, "%15[a-z_]:%u", kind, &byte) != 2) {
+            break;
+        }
+        twi_faults[twi_faults_count++] = (twi_fault_t){
+            .byte = byte,
+            .kind = strcmp(kind, "stuck") == 0 ? TWI_FAULT_STUCK : TWI_FAULT_BUS_ERROR,
+        };
+        value = strchr(value, ',');
+        value = value ? value + 1 : NULL;
+    }
+}
+
+// Период SCL в тактах: F_CPU / (16 + 2 * TWBR * 4^TWPS)
+static uint32_t twi_bit_cycles(void) {
+    return 16 + 2 * (uint32_t)TWBR * (1u << (2 * (TWSR & 0b11)));
+}
+
+static void twi_finish(uint8_t status, uint32_t bits) {
+    twi_status = status;
+    twi_busy = true;
+    twi_done_cycle = cycles + bits * twi_bit_cycles();
+}
+
+static void twi_release(void) {
+    if (twi_target && twi_target->stop) {
+        twi_target->stop(twi_target);
+    }
+    twi_target = NULL;
+    twi_owner = false;
+}
+
+static void twi_begin(uint8_t control) {
+    if (control & (1<<TWSTO)) {
+        twi_release();
+        if (!(control & (1<<TWSTA))) {
+            twi_stop_only = true;
+            twi_finish(0xF8, 1);
+            return;
+        }
+    }
+    if (control & (1<<TWSTA)) {
+        if (twi_target && twi_target->stop) {
+            twi_target->stop(twi_target); // Повторный START завершает обмен с прежним ведомым
+        }
+        twi_target = NULL;
+        twi_expect_address = true;
+        twi_finish(twi_owner ? 0x10 : 0x08, 1);
+        twi_owner = true;
+        return;
+    }
+    if (!twi_owner) {
+        return; // Байт без START: на шине ничего не происходит
+    }
+
+    twi_bytes++;
+    for (uint8_t i = 0; i < twi_faults_count; i++) {
+        if (twi_faults[i].byte == twi_bytes) {
+            if (twi_faults[i].kind == TWI_FAULT_STUCK) {
+                twi_stuck = true;
+                return;
+            }
+            twi_target = NULL;
+            twi_owner = false;
+            twi_finish(0x00, 9);
+            return;
+        }
+    }
+
+    if (twi_expect_address) {
+        twi_expect_address = false;
+        twi_reading = TWDR & 1;
+        twi_target = NULL;
+        for (uint8_t i = 0; i < twi_slaves_count; i++) {
+            if (twi_slaves[i]->address == TWDR >> 1 && twi_slaves[i]->start(twi_slaves[i], twi_reading)) {
+                twi_target = twi_slaves[i];
+                break;
+            }
+        }
+        twi_finish(twi_reading ? (twi_target ? 0x40 : 0x48) : (twi_target ? 0x18 : 0x20), 9);
+    } else if (!twi_reading) {
+        bool ack = twi_target && twi_target->write(twi_target, TWDR);
+        twi_finish(ack ? 0x28 : 0x30, 9);
+    } else {
+        TWDR = twi_target ? twi_target->read(twi_target) : 0xFF;
+        twi_finish((control & (1<<TWEA)) ? 0x50 : 0x58, 9);
+    }
+}
+
+// Команда: программа записала TWINT = 1, а флаг модели не поднят
+static void twi_take_request(void) {
+    if (!twi_flag && !twi_busy && !twi_stuck && (TWCR & (1<<TWEN)) && (TWCR & (1<<TWINT))) {
+        TWCR &= ~(1<<TWINT);
+        twi_begin(TWCR);
+    }
+}
+
+static void twi_vector(void) {
+    twi_flag = false; // Обработчик взял флаг (service_interrupts уже сбросил TWINT)
+    hal_native_twi();
+}
+
+static void twi_step(void) {
+    if (!(TWCR & (1<<TWEN))) {
+        // TWI выключен: шина отпущена, незавершенная операция прервана
+        twi_busy = false;
+        twi_stuck = false;
+        twi_flag = false;
+        twi_owner = false;
+        twi_target = NULL;
+        return;
+    }
+    if (twi_flag && !(TWCR & (1<<TWINT))) {
+        twi_flag = false; // Флаг сброшен программой без обработчика
+    }
+    if (twi_busy && cycles >= twi_done_cycle) {
+        twi_busy = false;
+        TWSR = twi_status | (TWSR & 0b11);
+        if (twi_stop_only) {
+            twi_stop_only = false;
+            TWCR &= ~(1<<TWSTO);
+        } else {
+            TWCR = (TWCR & ~(1<<TWSTO)) | (1<<TWINT);
+            twi_flag = true;
+        }
+    }
+    twi_take_request();
+}
+
+static int compare_stimuli(const void *a, const void *b) {
+    const stimulus_t *sa = a, *sb = b;
+    return sa->cycle < sb->cycle ? -1 : sa->cycle > sb->cycle;
+}
+
+static void load_stimuli(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(2);
+    }
+    char line[128];
+    size_t capacity = 0;
+    while (fgets(line, sizeof(line), file)) {
+        double time_us;
+        char kind[8], target[8];
+        unsigned value;
+        if (line[0] == '#' || sscanf(line, "%lf %7s %7s %u", &time_us, kind, target, &value) != 4 || strcmp(kind, "pin") != 0) {
+            continue; // Воздействия на АЦП в этой модели не поддерживаются
+        }
+        if (stimuli_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            stimuli = realloc(stimuli, capacity * sizeof(stimulus_t));
+        }
+        stimuli[stimuli_count++] = (stimulus_t){
+            .cycle = (uint64_t)(time_us * (F_CPU / 1000000)),
+            .port = target[0],
+            .bit = atoi(target + 1),
+            .level = value != 0,
+        };
+    }
+    fclose(file);
+    qsort(stimuli, stimuli_count, sizeof(stimulus_t), compare_stimuli);
+}
+
+static void init(void) {
+    initialized = true;
+    const char *value;
+    duration_cycles = (uint64_t)((value = getenv("HAL_NATIVE_DURATION_MS")) ? atoll(value) : 1000) * (F_CPU / 1000);
+    loop_cycles = (value = getenv("HAL_NATIVE_LOOP_CYCLES")) ? (uint32_t)atol(value) : 32;
+    trace = (value = getenv("HAL_NATIVE_TRACE")) && value[0] == '1';
+    if ((value = getenv("HAL_NATIVE_STIMULUS"))) {
+        load_stimuli(value);
+    }
+    twi_init();
+    update_pins();
+    last_pin[0] = PINB;
+    last_pin[1] = PINC;
+    last_pin[2] = PIND;
+}
+
+static void trace_ports(void) {
+    const volatile uint8_t *port[3] = {&PORTB, &PORTC, &PORTD};
+    for (int i = 0; i < 3; i++) {
+        if (*port[i] != last_port[i]) {
+            if (trace) {
+                printf("%10.3f ms PORT%c %02X -> %02X\n", cycles * 1000.0 / F_CPU, "BCD"[i], last_port[i], *port[i]);
+            }
+            last_port[i] = *port[i];
+        }
+    }
+}
+
+void hal_native_set_pin(char port, uint8_t bit, bool level) {
+    int index = port_index(port);
+    if (index < 0) {
+        return;
+    }
+    input_driven[index] |= (1 << bit);
+    if (level) {
+        input_level[index] |= (1 << bit);
+    } else {
+        input_level[index] &= ~(1 << bit);
+    }
+    update_inputs();
+}
+
+void hal_native_advance(uint32_t count) {
+    if (!initialized) {
+        init();
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        cycles++;
+
+        while (stimuli_next < stimuli_count && stimuli[stimuli_next].cycle <= cycles) {
+            const stimulus_t *stimulus = &stimuli[stimuli_next++];
+            hal_native_set_pin(stimulus->port, stimulus->bit, stimulus->level);
+        }
+
+        uint16_t prescaler0 = PRESCALERS[TCCR0B & 0b111];
+        if (prescaler0 && ++timer0_prescaler_count >= prescaler0) {
+            timer0_prescaler_count = 0;
+            timer0_tick();
+        }
+        uint16_t prescaler1 = PRESCALERS[TCCR1B & 0b111];
+        if (prescaler1 && ++timer1_prescaler_count >= prescaler1) {
+            timer1_prescaler_count = 0;
+            timer1_tick();
+        }
+        twi_step();
+
+        service_interrupts();
+    }
+    update_inputs(); // Программа могла поменять DDRx/PORTx
+    twi_take_request(); // И записать команду TWI: до service_interrupts(), иначе TWINT примется за флаг
+    service_interrupts();
+    trace_ports();
+}
+
+bool hal_running(void) {
+    if (!initialized) {
+        init(); // loop_cycles задается в init()
+    }
+    hal_native_advance(loop_cycles);
+    return cycles < duration_cycles;
+}
+
+uint64_t hal_native_cycles(void) {
+    return cycles;
+}
+
+#endif // __AVR__
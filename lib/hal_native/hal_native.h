@@ -0,0 +1,227 @@
+/**
+ * Модель ATmega328P для сборки примеров на компьютере (platform = native).
+ *
+ * Регистры - обычные переменные. Время модели измеряется в тактах 16 MHz и продвигается в hal_running():
+ * каждая итерация основного цикла добавляет HAL_NATIVE_LOOP_CYCLES тактов (по умолчанию 32).
+ * За это время моделируются Timer0 и Timer1 (режимы Normal и CTC, совпадение A/B, переполнение, захват ICP1),
+ * внешние прерывания INT0/INT1, прерывания по изменению пинов PCINT0..2 и ведущий TWI (I2C) с ведомыми
+ * устройствами на шине (hal_native_twi_attach()).
+ * Если флаг I в SREG установлен, для каждого поднятого флага с разрешенным прерыванием вызывается обработчик ISR().
+ *
+ * Флаги прерываний EIFR, PCIFR, TIFR0, TIFR1 сбрасываются записью 1, как на AVR: `TIFR1 = (1<<ICF1)` сбрасывает
+ * только ICF1. Чтобы отличить запись от чтения, эти регистры 16-битные: в старшем байте модель хранит метку,
+ * присваивание ее стирает. Поэтому флаги проверяются маской (`TIFR1 & (1<<ICF1)`), а сбрасываются присваиванием:
+ * `TIFR1 |= (1<<ICF1)` (sbi на AVR) модель не видит, если флаг уже поднят.
+ *
+ * Переменные окружения:
+ *  HAL_NATIVE_DURATION_MS - сколько миллисекунд модели выполнить (по умолчанию 1000), затем hal_running() вернет 0;
+ *  HAL_NATIVE_LOOP_CYCLES - тактов на одну итерацию основного цикла;
+ *  HAL_NATIVE_STIMULUS    - файл воздействий в формате tools/simbench ("<time_us> pin B0 <0|1>");
+ *  HAL_NATIVE_TRACE=1     - печатать изменения PORTB/PORTC/PORTD с временем модели;
+ *  HAL_NATIVE_TWI_MEMORY  - адреса ведомых "память с указателем" (как EEPROM 24C02 или регистры датчика):
+ *                           "0x50,0x48". Первый записанный байт - указатель, следующие пишутся с указателя,
+ *                           чтение - с указателя, с автоинкрементом. Начальное содержимое: байт i = i.
+ *                           После записи данных (STOP) 5 ms идет цикл записи: адрес не подтверждается (NACK);
+ *  HAL_NATIVE_TWI_FAULT   - сбой на N-м байте шины (адрес или данные, с 1): "bus_error:5" - ошибка шины
+ *                           (статус 0x00), "stuck:12" - ведомый держит шину, TWINT больше не поднимается,
+ *                           пока TWI не выключен (TWEN = 0). Несколько сбоев - через запятую.
+ *
+ * Обработчики прерываний объявлены слабыми символами: вектор без ISR() в программе просто ничего не делает.
+ */
+
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+// --- Регистры ---
+
+extern volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+extern volatile uint8_t SREG, EICRA, EIMSK, PCICR, PCMSK0, PCMSK1, PCMSK2;
+extern volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0;
+extern volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1;
+extern volatile uint16_t EIFR, PCIFR, TIFR0, TIFR1; // Запись 1 сбрасывает флаг (см. выше)
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+extern volatile uint8_t TWBR, TWSR, TWAR, TWDR, TWCR;
+extern volatile uint8_t PRR, ADCSRA, ACSR, ASSR; // Только хранят значение: тактирование модулей не моделируется
+
+// --- Биты ---
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define SREG_I 7
+
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define INT0 0
+#define INT1 1
+#define INTF0 0
+#define INTF1 1
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PCINT0 0
+
+#define WGM00 0
+#define WGM01 1
+#define COM0B0 4
+#define COM0B1 5
+#define COM0A0 6
+#define COM0A1 7
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM02 3
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+#define TOV0 0
+#define OCF0A 1
+#define OCF0B 2
+
+#define WGM10 0
+#define WGM11 1
+#define COM1B0 4
+#define COM1B1 5
+#define COM1A0 6
+#define COM1A1 7
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define WGM13 4
+#define ICES1 6
+#define ICNC1 7
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+#define TWPS0 0
+#define TWPS1 1
+
+#define PRADC 0
+#define PRUSART0 1
+#define PRSPI 2
+#define PRTIM1 3
+#define PRTIM0 5
+#define PRTIM2 6
+#define PRTWI 7
+#define ADEN 7
+#define ACD 7
+#define AS2 5
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+
+// --- Прерывания ---
+
+#define INT0_vect hal_native_int0
+#define INT1_vect hal_native_int1
+#define PCINT0_vect hal_native_pcint0
+#define PCINT1_vect hal_native_pcint1
+#define PCINT2_vect hal_native_pcint2
+#define TIMER1_CAPT_vect hal_native_timer1_capt
+#define TIMER1_COMPA_vect hal_native_timer1_compa
+#define TIMER1_COMPB_vect hal_native_timer1_compb
+#define TIMER1_OVF_vect hal_native_timer1_ovf
+#define TIMER0_COMPA_vect hal_native_timer0_compa
+#define TIMER0_COMPB_vect hal_native_timer0_compb
+#define TIMER0_OVF_vect hal_native_timer0_ovf
+#define TWI_vect hal_native_twi
+
+#define ISR(vector, ...) void vector(void); void vector(void)
+
+#define sei() (SREG |= (1<<SREG_I))
+#define cli() (SREG &= ~(1<<SREG_I))
+
+// --- Сон ---
+
+// Режимы различаются только на AVR: в модели сон - продвижение времени до следующего шага (как итерация цикла),
+// после него программа проверяет флаги, как после пробуждения прерыванием
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC 1
+#define SLEEP_MODE_PWR_DOWN 2
+#define SLEEP_MODE_PWR_SAVE 3
+#define SLEEP_MODE_STANDBY 6
+#define SLEEP_MODE_EXT_STANDBY 7
+#define set_sleep_mode(mode) ((void)(mode))
+#define sleep_enable() ((void)0)
+#define sleep_disable() ((void)0)
+#define sleep_bod_disable() ((void)0)
+#define sleep_cpu() ((void)hal_running())
+
+// --- Управление моделью ---
+
+// Шаг основного цикла: продвигает время модели. Возвращает false, когда время HAL_NATIVE_DURATION_MS вышло.
+bool hal_running(void);
+
+// Продвигает время модели на cycles тактов (таймеры, воздействия, прерывания).
+void hal_native_advance(uint32_t cycles);
+
+// Задает уровень на входе (port - 'B', 'C' или 'D'), как внешний сигнал. Фронты вызывают ICP1/INTx/PCINTx.
+void hal_native_set_pin(char port, uint8_t bit, bool level);
+
+// Текущее время модели в тактах.
+uint64_t hal_native_cycles(void);
+
+// --- Ведомые устройства TWI ---
+
+typedef struct hal_native_twi_slave hal_native_twi_slave_t;
+
+struct hal_native_twi_slave {
+    uint8_t address; // 7-битный адрес
+    bool (*start)(hal_native_twi_slave_t *slave, bool read); // Адрес принят: true - ACK
+    bool (*write)(hal_native_twi_slave_t *slave, uint8_t byte); // true - ACK
+    uint8_t (*read)(hal_native_twi_slave_t *slave);
+    void (*stop)(hal_native_twi_slave_t *slave); // STOP (может быть NULL)
+};
+
+// Подключает ведомое устройство к шине (до 8). Устройство должно существовать до конца программы.
+void hal_native_twi_attach(hal_native_twi_slave_t *slave);
+
+#endif // HAL_NATIVE_H
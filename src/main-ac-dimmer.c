@@ -0,0 +1,204 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Диммер нагрузки 220 V (фазовое управление симистором): детектор перехода через ноль на аналоговом компараторе,
+ * метки времени через захват Timer1, импульс на управляющий электрод через сравнение OCR1A.
+ *
+ * ВНИМАНИЕ: сетевое напряжение опасно для жизни. Схема подключения - только через гальваническую развязку
+ * (трансформатор или оптопара для детектора, оптосимистор MOC3021/MOC3052 для симистора).
+ *
+ * Подключение:
+ *  - AIN0/PD6(D6) - опорное напряжение ~2.5 V (делитель 10K/10K от 5 V);
+ *  - AIN1/PD7(D7) - сетевое напряжение с понижающего трансформатора через делитель со смещением 2.5 V
+ *    (синусоида 0.5..4.5 V вокруг 2.5 V);
+ *  - OC1A/PB1(D9) - светодиод оптосимистора через резистор.
+ *
+ * Как это работает (все в прерываниях, main только задает dimmer_level):
+ *  1. Выход компаратора подключен к захвату Timer1 (ACSR.ACIC = 1). ACO = 1, когда AIN0 > AIN1, поэтому захват
+ *     по фронту ACO (ICES1 = 1) - это переход синусоиды на AIN1 через опорное напряжение вниз: Timer1 аппаратно
+ *     записывает TCNT1 в ICR1 - метка времени без задержки прерывания.
+ *     Подавитель шума захвата (ICNC1) пропускает только уровень, стабильный 4 такта.
+ *  2. TIMER1_CAPT_vect - фазовая автоподстройка (ФАПЧ, PLL): предсказанное время следующего перехода сравнивается
+ *     с захваченным, ошибка поправляет фазу (на 1/4) и период (на 1/32). Так дрожание компаратора и помехи
+ *     сглаживаются, а частота сети (49..51 Hz, 60 Hz) отслеживается. Захваты раньше полупериода после перехода
+ *     (дребезг: у компаратора нет гистерезиса) не учитываются, захват дальше 1/8 периода от предсказания
+ *     считается помехой и пропускается. При захвате частоты период короче MIN_PERIOD_TICKS - тоже дребезг:
+ *     такой захват пропускается (отсчет периода идет от предыдущего принятого захвата), счет точных захватов
+ *     не сбрасывается - иначе дребезг на каждом переходе не дал бы ФАПЧ захватить частоту.
+ *  3. От отфильтрованного момента перехода рассчитываются два момента включения симистора - для отрицательной
+ *     и положительной полуволны: переход + задержка и переход + полупериод + задержка.
+ *     Задержка = полупериод * (255 - dimmer_level) / 256.
+ *  4. Импульс включения формирует аппаратура: OC1A устанавливается при совпадении (COM1A = 11), затем
+ *     TIMER1_COMPA_vect переключает OC1A на сброс при следующем совпадении через GATE_PULSE_US.
+ *     Момент включения не зависит от задержки входа в прерывание.
+ *
+ * Если переходы через ноль пропали (сеть отключена, обрыв детектора), симистор больше не включается:
+ * включения планируются только от захватов, и после LOCK_LOSS_MISSES пропущенных периодов ФАПЧ снова
+ * захватывает частоту с нуля.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GATE_PIN PB1 // OC1A/PB1(D9)
+
+#define US_TO_TICKS(us) ((us) / 4) // Timer1, предделитель 64: 4 us на тик, 65536 тиков - 262 ms (13 периодов сети)
+#define NOMINAL_PERIOD_TICKS US_TO_TICKS(20000UL) // 50 Hz
+#define MIN_PERIOD_TICKS US_TO_TICKS(14284UL) // 70 Hz
+#define MAX_PERIOD_TICKS US_TO_TICKS(25000UL) // 40 Hz
+#define GATE_PULSE_US 100
+#define FIRE_MARGIN_US 300 // Не включать ближе к переходу через ноль (ток удержания симистора)
+#define ZC_OFFSET_US 0 // Задержка детектора (фильтр, порог компаратора), если известна
+#define LOCK_COUNT 8 // Последовательных точных захватов до начала работы
+#define LOCK_LOSS_MISSES 4
+
+volatile uint8_t dimmer_level; // 0 - выключено, 255 - максимальная яркость. Пишет main.
+
+// ФАПЧ: время и период с 8 битами дробной части (тики Timer1 * 256)
+uint32_t pll_period = NOMINAL_PERIOD_TICKS << 8;
+uint32_t pll_zero_cross; // Последний отфильтрованный переход
+uint16_t pll_last_capture;
+uint8_t pll_good; // Последовательных захватов с одинаковым периодом
+uint8_t pll_misses;
+bool pll_locked;
+
+// Планировщик импульсов
+uint16_t fire_second; // Время включения во второй полуволне
+uint8_t fire_state; // 0 - нет, 1 - ждем включения 1, 2 - импульс 1, 3 - ждем включения 2, 4 - импульс 2
+
+static inline void gate_schedule(uint16_t time) {
+    OCR1A = time;
+    TCCR1A = (1<<COM1A1) | (1<<COM1A0); // Установить OC1A при совпадении
+}
+
+static void dimmer_fire(uint16_t zero_cross) {
+    if (fire_state == 2 || fire_state == 4) {
+        // Переход пришел раньше конца импульса (скачок фазы сети): снять импульс сразу
+        TCCR1A = (1<<COM1A1);
+        TCCR1C = (1<<FOC1A);
+    }
+    uint8_t level = dimmer_level;
+    if (level == 0) {
+        fire_state = 0;
+        return;
+    }
+    uint16_t half = pll_period >> 9;
+    uint16_t delay = ((uint32_t)half * (uint8_t)(255 - level)) >> 8;
+    uint16_t min_delay = US_TO_TICKS(FIRE_MARGIN_US);
+    uint16_t max_delay = half - US_TO_TICKS(FIRE_MARGIN_US + GATE_PULSE_US);
+    delay = delay < min_delay ? min_delay : delay > max_delay ? max_delay : delay;
+
+    uint16_t first = zero_cross + US_TO_TICKS(ZC_OFFSET_US) + delay;
+    uint16_t soonest = TCNT1 + US_TO_TICKS(GATE_PULSE_US);
+    if ((int16_t)(first - soonest) < 0) {
+        first = soonest; // Отфильтрованный переход раньше захвата: время включения уже прошло
+    }
+    fire_second = first + half;
+    fire_state = 1;
+    gate_schedule(first);
+}
+
+ISR(TIMER1_CAPT_vect) {
+    uint16_t capture = ICR1;
+
+    if (!pll_locked) {
+        // Захват частоты: период - разность соседних захватов, фаза - последний захват
+        uint16_t period = capture - pll_last_capture;
+        if (period < MIN_PERIOD_TICKS) {
+            return; // Дребезг компаратора около перехода: захват не учитывается, счет точных захватов сохраняется
+        }
+        pll_last_capture = capture;
+        if (period > MAX_PERIOD_TICKS) {
+            pll_good = 0;
+            return;
+        }
+        int16_t error = (int16_t)(period - (uint16_t)(pll_period >> 8));
+        int16_t window = period >> 6;
+        pll_good = (error > -window && error < window) ? pll_good + 1 : 0;
+        pll_period = (uint32_t)period << 8;
+        pll_zero_cross = (uint32_t)capture << 8;
+        if (pll_good >= LOCK_COUNT) {
+            pll_locked = true;
+            pll_misses = 0;
+        }
+        return;
+    }
+
+    // Время от последнего перехода (по модулю 65536 тиков, то есть до 13 периодов)
+    uint16_t since = capture - (uint16_t)(pll_zero_cross >> 8);
+    uint16_t period = pll_period >> 8;
+    if (since < period / 2) {
+        return; // Дребезг компаратора около перехода
+    }
+    int16_t window = period >> 3;
+    int32_t error = (int32_t)since - period;
+    while (error > (int32_t)(period / 2)) {
+        // Пропущен переход (помеха на входе): продолжаем по предсказанию
+        pll_zero_cross += pll_period;
+        error -= period;
+    }
+    if (error < -window || error > window) {
+        if (++pll_misses >= LOCK_LOSS_MISSES) {
+            pll_locked = false;
+            pll_good = 0;
+            pll_last_capture = capture;
+        }
+        return;
+    }
+    pll_misses = 0;
+
+    uint32_t predicted = pll_zero_cross + pll_period;
+    pll_zero_cross = predicted + (error << 6); // Фаза: 1/4 ошибки (<< 8 >> 2)
+    pll_period += error << 3; // Период: 1/32 ошибки (<< 8 >> 5)
+    if (pll_period < (MIN_PERIOD_TICKS << 8)) {
+        pll_period = MIN_PERIOD_TICKS << 8;
+    } else if (pll_period > (MAX_PERIOD_TICKS << 8)) {
+        pll_period = MAX_PERIOD_TICKS << 8;
+    }
+
+    dimmer_fire(pll_zero_cross >> 8);
+}
+
+ISR(TIMER1_COMPA_vect) {
+    switch (fire_state) {
+        case 1: // OC1A установлен аппаратно: симистор включается
+        case 3:
+            OCR1A += US_TO_TICKS(GATE_PULSE_US);
+            TCCR1A = (1<<COM1A1); // Сбросить OC1A при следующем совпадении
+            fire_state++;
+            break;
+        case 2: // Конец первого импульса: следующая полуволна
+            fire_state = 3;
+            gate_schedule(fire_second);
+            break;
+        default: // Конец второго импульса
+            fire_state = 0;
+            break;
+    }
+}
+
+int main(void) {
+    DDRB |= (1<<GATE_PIN);
+
+    DIDR1 = (1<<AIN1D) | (1<<AIN0D); // Цифровые входы на AIN0/AIN1 не нужны (меньше потребление и помехи)
+    ACSR = (1<<ACIC); // Компаратор включен, выход - на захват Timer1
+
+    TCCR1A = 0; // Normal, OC1A отключен
+    TIMSK1 = (1<<ICIE1) | (1<<OCIE1A);
+    TCCR1B = (1<<ICNC1) | (1<<ICES1) | (1<<CS11) | (1<<CS10); // Подавитель шума, по фронту, предделитель 64
+
+    sei();
+
+    // main только меняет уровень: плавно от минимума до максимума и обратно за ~5 s
+    int8_t step = 1;
+    while (1) {
+        for (volatile uint16_t i = 0; i < 40000; i++);
+        uint8_t level = dimmer_level;
+        if ((step > 0 && level == 255) || (step < 0 && level == 0)) {
+            step = -step;
+        }
+        dimmer_level = level + step;
+    }
+}
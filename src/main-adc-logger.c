@@ -0,0 +1,269 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Журнал показаний АЦП в EEPROM со сжатием: разность с предыдущим отсчетом, zig-zag и запись кодом
+ * переменной длины по 4 бита (nibble). Декодер на компьютере - tools/adc_log_decode.py.
+ *
+ * Датчик - фоторезистор на A5, как в main-adc.c. Отсчет раз в LOG_PERIOD_MS: Timer1 в режиме CTC,
+ * совпадение B запускает преобразование (auto trigger), ADC_vect кладет результат в очередь
+ * (include/spsc_queue.h), основной цикл сжимает и пишет в EEPROM.
+ *
+ * Без сжатия отсчет занимает 2 байта, и 1 KB EEPROM вмещает ~500 отсчетов (8 минут раз в секунду).
+ * Медленный сигнал меняется между отсчетами на единицы младшего разряда, поэтому пишется разность:
+ *  - zig-zag переводит разность со знаком в число без знака: 0, -1, 1, -2, 2... -> 0, 1, 2, 3, 4...;
+ *  - число записывается тетрадами по 3 бита данных (младшие первыми), бит 3 - "будет еще тетрада".
+ *    Разность -4..3 - 1 тетрада (4 бита вместо 16), -32..31 - 2, -256..255 - 3, скачок на всю шкалу - 4.
+ * Для плавного сигнала это 4-5 бит на отсчет, сжатие в 3-4 раза: ~1800 отсчетов (30 минут).
+ *
+ * EEPROM разбита на страницы по LOG_PAGE_SIZE байт. Страница собирается в RAM и записывается целиком
+ * одним eeprom_update_block(), когда заполнена. Внутренняя EEPROM ATmega328P пишет побайтно (3.3 ms на байт,
+ * 106 ms на страницу), поэтому страница - не аппаратная единица записи, а граница независимого декодирования:
+ * каждая страница начинается с полного значения отсчета, и испорченная страница не портит следующие.
+ * Пока страница пишется, отсчеты ждут в очереди.
+ *
+ * Плата сбрасывается при открытии порта (DTR), поэтому после сброса журнал продолжается со следующей
+ * свободной страницы и новым номером сеанса. Незаполненная страница в RAM при сбросе теряется (до 56 отсчетов):
+ * дамп через tools/adc_log_decode.py --port на плате с автосбросом содержит только страницы EEPROM
+ * (см. описание декодера).
+ *
+ * Команды по USART (1 000 000 бод):
+ *  - 'd' - дамп журнала (страницы EEPROM и текущая страница из RAM), формат - в tools/adc_log_decode.py;
+ *  - 'e' - стереть журнал (пометить все страницы пустыми, ~100 ms).
+ * После каждой записанной страницы печатается строка со степенью сжатия: samples, bytes (занято в EEPROM),
+ * raw_bytes (2 байта на отсчет) и ratio.
+ * PB5(D13) горит, когда журнал заполнен - новые отсчеты не пишутся.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "spsc_queue.h"
+#include "power_manager.h"
+#include "usart_polled.h"
+
+#define LED_FULL_PIN PB5 // PB5(D13)
+
+#define LOG_PERIOD_MS 1000
+#define LOG_PAGE_SIZE 32
+#define LOG_PAGES 31 // 992 байта из 1024, остальное - номер сеанса
+#define LOG_PAGE_EMPTY 0xFF // count пустой страницы (стертая EEPROM)
+
+// --- Страницы журнала ---
+
+typedef struct {
+    uint16_t first; // Первый отсчет страницы, полностью
+    uint8_t count; // Отсчетов в странице (с первым), LOG_PAGE_EMPTY - пустая
+    uint8_t session; // Номер сеанса (увеличивается при каждом запуске)
+    uint8_t data[LOG_PAGE_SIZE - 4]; // Разности, тетрады: в байте сначала младшая
+} log_page_t;
+
+_Static_assert(sizeof(log_page_t) == LOG_PAGE_SIZE, "log_page_t: размер страницы");
+
+log_page_t EEMEM log_pages[LOG_PAGES];
+uint8_t EEMEM log_session_eemem;
+
+log_page_t log_page; // Собирается в RAM
+uint8_t log_nibbles; // Записано тетрад в log_page.data
+uint16_t log_previous;
+uint8_t log_page_index; // Страница EEPROM для log_page, LOG_PAGES - журнал заполнен
+uint8_t log_session;
+uint32_t log_samples; // Отсчетов в журнале (с записанными до сброса)
+
+static void log_new_page(void) {
+    memset(&log_page, 0, sizeof(log_page));
+    log_page.session = log_session;
+    log_nibbles = 0;
+}
+
+// Находит первую пустую страницу и начинает новый сеанс
+void log_init(void) {
+    log_session = eeprom_read_byte(&log_session_eemem) + 1;
+    eeprom_update_byte(&log_session_eemem, log_session);
+    log_samples = 0;
+    for (log_page_index = 0; log_page_index < LOG_PAGES; log_page_index++) {
+        uint8_t count = eeprom_read_byte(&log_pages[log_page_index].count);
+        if (count == 0 || count == LOG_PAGE_EMPTY) {
+            break;
+        }
+        log_samples += count;
+    }
+    log_new_page();
+}
+
+void log_erase(void) {
+    for (uint8_t i = 0; i < LOG_PAGES; i++) {
+        eeprom_update_byte(&log_pages[i].count, LOG_PAGE_EMPTY); // Данные страницы без count не читаются
+    }
+    log_page_index = 0;
+    log_samples = 0;
+    log_new_page();
+}
+
+static inline void log_put_nibble(uint8_t nibble) {
+    uint8_t *cell = &log_page.data[log_nibbles >> 1];
+    *cell |= (log_nibbles & 1) ? (nibble << 4) : nibble;
+    log_nibbles++;
+}
+
+// Тетрад для значения zig-zag: по 3 бита данных в тетраде
+static inline uint8_t log_nibble_count(uint16_t zigzag) {
+    uint8_t count = 1;
+    while (zigzag >= 8) {
+        zigzag >>= 3;
+        count++;
+    }
+    return count;
+}
+
+// Записывает заполненную страницу. true - страница записана (можно печатать статистику).
+static bool log_flush(void) {
+    if (log_page_index >= LOG_PAGES || log_page.count == 0) {
+        return false;
+    }
+    eeprom_update_block(&log_page, &log_pages[log_page_index], sizeof(log_page));
+    log_page_index++;
+    log_new_page();
+    return true;
+}
+
+// Добавляет отсчет. true - перед ним записана заполненная страница.
+bool log_append(uint16_t sample) {
+    if (log_page_index >= LOG_PAGES) {
+        return false;
+    }
+    bool flushed = false;
+    if (log_page.count) {
+        int16_t delta = sample - log_previous;
+        uint16_t zigzag = ((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15);
+        uint8_t nibbles = log_nibble_count(zigzag);
+        if (log_nibbles + nibbles <= sizeof(log_page.data) * 2) {
+            while (zigzag >= 8) {
+                log_put_nibble((zigzag & 0x07) | 0x08);
+                zigzag >>= 3;
+            }
+            log_put_nibble(zigzag);
+            log_page.count++;
+            log_previous = sample;
+            log_samples++;
+            return false;
+        }
+        flushed = log_flush();
+        if (log_page_index >= LOG_PAGES) {
+            return flushed;
+        }
+    }
+    log_page.first = sample;
+    log_page.count = 1;
+    log_previous = sample;
+    log_samples++;
+    return flushed;
+}
+
+// Байт в EEPROM и RAM: записанные страницы и заполненная часть текущей
+uint16_t log_bytes(void) {
+    uint16_t bytes = (uint16_t)log_page_index * LOG_PAGE_SIZE;
+    if (log_page.count) {
+        bytes += LOG_PAGE_SIZE - sizeof(log_page.data) + (log_nibbles + 1) / 2;
+    }
+    return bytes;
+}
+
+void print_ratio(void) {
+    uint16_t bytes = log_bytes();
+    uint32_t raw_bytes = log_samples * 2;
+    uint32_t ratio_x100 = bytes ? raw_bytes * 100 / bytes : 0;
+    usart_print_blocking("samples=");
+    usart_print_uint_blocking(log_samples);
+    usart_print_blocking(" bytes=");
+    usart_print_uint_blocking(bytes);
+    usart_print_blocking(" raw_bytes=");
+    usart_print_uint_blocking(raw_bytes);
+    usart_print_blocking(" ratio=");
+    usart_print_uint_blocking(ratio_x100 / 100);
+    usart_print_blocking(ratio_x100 % 100 < 10 ? ".0" : ".");
+    usart_print_uint_blocking(ratio_x100 % 100);
+    usart_print_blocking("\r\n");
+}
+
+// Дамп: "ADL\x01", период в ms (2 байта), размер страницы, число страниц, затем страницы.
+// Последней идет текущая страница из RAM, если в ней есть отсчеты.
+void log_dump(void) {
+    uint16_t period_ms = LOG_PERIOD_MS;
+    uint8_t page_size = LOG_PAGE_SIZE;
+    uint8_t pages = log_page_index + (log_page.count ? 1 : 0);
+    usart_write_blocking("ADL\x01", 4);
+    usart_write_blocking(&period_ms, sizeof(period_ms));
+    usart_write_blocking(&page_size, sizeof(page_size));
+    usart_write_blocking(&pages, sizeof(pages));
+    for (uint8_t i = 0; i < log_page_index; i++) {
+        log_page_t page;
+        eeprom_read_block(&page, &log_pages[i], sizeof(page));
+        usart_write_blocking(&page, sizeof(page));
+    }
+    if (log_page.count) {
+        usart_write_blocking(&log_page, sizeof(log_page));
+    }
+}
+
+// --- АЦП ---
+
+SPSC_QUEUE(sample_queue, uint16_t, 4)
+
+ISR(ADC_vect) {
+    sample_queue_push(ADC);
+}
+
+EMPTY_INTERRUPT(TIMER1_COMPB_vect); // Только сброс OCF1B: следующий запуск АЦП - по следующему фронту флага
+
+void adc_init(void) {
+    pm_acquire(PM_ADC);
+    pm_acquire(PM_TIMER1);
+    ADMUX = (1<<REFS0) | (1<<MUX2) | (1<<MUX0); // AVcc, ADC5 (A5)
+    ADCSRB = (1<<ADTS2) | (1<<ADTS0); // Запуск по совпадению B Timer1
+    // 125 kHz, auto trigger, прерывание по окончании
+    ADCSRA = (1<<ADEN) | (1<<ADATE) | (1<<ADIE) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0);
+
+    // Timer1: CTC, предделитель 1024 (64 us), период LOG_PERIOD_MS; совпадение B - в конце периода
+    TCCR1A = 0;
+    OCR1A = (uint32_t)LOG_PERIOD_MS * (F_CPU / 1024) / 1000 - 1;
+    OCR1B = OCR1A;
+    TIMSK1 = (1<<OCIE1B);
+    TCCR1B = (1<<WGM12) | (1<<CS12) | (1<<CS10);
+}
+
+int main(void) {
+    pm_init(); // Модули захватываются перед usart_init() и в adc_init()
+    DDRB |= (1<<LED_FULL_PIN);
+
+    pm_acquire(PM_USART0);
+    usart_init(true); // Прием команд d/e
+    log_init();
+    adc_init();
+    sei();
+
+    while (1) {
+        uint16_t sample;
+        if (sample_queue_pop(&sample)) {
+            if (log_append(sample)) {
+                print_ratio();
+            }
+            if (log_page_index >= LOG_PAGES) {
+                PORTB |= (1<<LED_FULL_PIN);
+            }
+        }
+
+        switch (usart_read()) {
+            case 'd':
+                log_dump();
+                break;
+            case 'e':
+                log_erase();
+                PORTB &= ~(1<<LED_FULL_PIN);
+                break;
+        }
+    }
+}
@@ -5,11 +5,10 @@
  * Не используем функции задержек `_delay_ms()` из библиотеки AVR.
  */
 
-#include <avr/io.h>
-#include <avr/interrupt.h>
+#include "hal.h"
 #include <stdint.h>
 #include <stdbool.h>
-#include <stdlib.h> // NULL definition
+#include <stddef.h> // NULL definition
 
 #define LED_RED_PIN PB3 // PB3(D11)
 #define LED_YELLOW_PIN PB2 // PB2(D10)
@@ -110,7 +109,7 @@ int main(void) {
     timer_start(&timer_green);
     timer_start(&timer_blue);
 
-    while(1) {
+    while (hal_running()) {
         timer_next_tick(&timer_red);
         timer_next_tick(&timer_yellow);
         timer_next_tick(&timer_green);
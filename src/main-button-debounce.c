@@ -0,0 +1,107 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Подавление дребезга кнопок без задержек и без запрета прерываний.
+ *
+ * В main-external-interrupt.c и main-external-interrupt-pin-change.c одна кнопка, и для нее хватает времени последнего
+ * фронта и проверки уровня. Здесь кнопок до 8, и каждая подтверждается своим счетчиком.
+ *
+ * Здесь:
+ * - прерывание PCINT2 по изменению любого пина PORTD только запоминает время последнего фронта;
+ * - прерывание Timer0 (1 ms) раз в 5 ms опрашивает порт и пропускает через "вертикальные счетчики"
+ *   только те изменения, которые продержались 4 опроса подряд (20 ms). Порт опрашивается только в течение
+ *   DEBOUNCE_WINDOW_MS после последнего фронта, остальное время прерывание лишь считает миллисекунды.
+ *
+ * Вертикальный счетчик - это 2-битный счетчик для каждого бита порта, разложенный по двум байтам (ct0 - младшие биты,
+ * ct1 - старшие биты). Одна операция над байтами обновляет сразу 8 счетчиков, поэтому 8 кнопок порта
+ * обрабатываются за ~10 инструкций.
+ *
+ * Глобальные прерывания не запрещаются нигде. Каждое нажатие переключает бит в key_press_toggle (пишет только прерывание),
+ * а main помнит, какие переключения уже обработал (key_press_seen, пишет только main).
+ * Чтение одного байта атомарно, поэтому cli() не нужен.
+ *
+ * Программа. Кнопки на PD2..PD7 (D2..D7) замыкаются на GND, каждая кнопка включает и выключает свой светодиод на PB0..PB5 (D8..D13).
+ * Пины PD0/PD1 заняты USB-UART платы, но алгоритм обрабатывает все 8 бит порта: достаточно поменять BUTTONS_MASK.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+
+#define BUTTONS_MASK ((1<<PD2) | (1<<PD3) | (1<<PD4) | (1<<PD5) | (1<<PD6) | (1<<PD7))
+#define LEDS_MASK ((1<<PB0) | (1<<PB1) | (1<<PB2) | (1<<PB3) | (1<<PB4) | (1<<PB5))
+#define BUTTONS_TO_LEDS_SHIFT 2 // PD2 -> PB0, ..., PD7 -> PB5
+
+#define DEBOUNCE_TICK_MS 5 // Период опроса кнопок
+#define DEBOUNCE_WINDOW_MS (4 * DEBOUNCE_TICK_MS) // Состояние должно держаться 4 опроса подряд
+
+volatile uint16_t count_ms; // Пишется только в TIMER0_COMPA_vect
+volatile uint16_t edge_ms; // Время последнего фронта на кнопках
+volatile uint8_t key_press_toggle; // Бит переключается при каждом подтвержденном нажатии
+
+ISR(PCINT2_vect) {
+  edge_ms = count_ms; // Прерывания не вложены, поэтому 16-битное значение читается целиком
+}
+
+ISR(TIMER0_COMPA_vect) {
+  static uint8_t ct0 = 0xFF, ct1 = 0xFF; // Вертикальные счетчики (0xFF - счет не начат)
+  static uint8_t key_state; // Подтвержденное состояние кнопок (1 - нажата)
+  static uint8_t tick;
+
+  count_ms++;
+
+  if (++tick < DEBOUNCE_TICK_MS) {
+    return;
+  }
+  tick = 0;
+
+  // Опрос только в окне после последнего фронта: в (edge_ms, edge_ms + DEBOUNCE_WINDOW_MS] попадают ровно 4 опроса,
+  // и все они после фронта, поэтому установившийся уровень успевает досчитать до конца. Уровень без фронта
+  // не меняется, так что вне окна подтверждать нечего. Если фронтов не было 65 s, разность переходит через 0
+  // и окно лишний раз открывается на 20 ms - это только холостой опрос.
+  if ((uint16_t)(count_ms - edge_ms) > DEBOUNCE_WINDOW_MS) {
+    ct0 = ct1 = 0xFF; // Дребезг закончился, нечего считать
+    return;
+  }
+
+  uint8_t changed = (key_state ^ ~PIND) & BUTTONS_MASK; // Кнопки, состояние которых отличается от подтвержденного
+
+  ct0 = ~(ct0 & changed); // Счетчики не изменившихся кнопок сбрасываются
+  ct1 = ct0 ^ (ct1 & changed);
+  changed &= ct0 & ct1; // Счетчик досчитал до конца (4 опроса подряд)
+  key_state ^= changed;
+  key_press_toggle ^= key_state & changed; // Отмечаем только нажатия (не отпускания)
+}
+
+// Возвращает кнопки, нажатые с прошлого вызова.
+uint8_t get_key_press(void) {
+  static uint8_t key_press_seen;
+
+  uint8_t pressed = key_press_toggle ^ key_press_seen;
+  key_press_seen ^= pressed;
+  return pressed;
+}
+
+int main(void) {
+  DDRB |= LEDS_MASK; // Настройка светодиодов на выход
+
+  // Пины кнопок на вход (по умолчанию), подтягиваем к HIGH через встроенный резистор
+  PORTD |= BUTTONS_MASK;
+
+  PCICR |= (1<<PCIE2); // Разрешить прерывания на группе контактов PCIE2 (PORTD)
+  PCMSK2 |= BUTTONS_MASK; // Разрешить прерывания на пинах кнопок
+
+  TIMSK0 |= (1<<OCIE0A); // Включить прерывание при совпадении для Timer0
+  TCCR0A |= (1<<WGM01); // Задаем режим CTC для Timer0
+  OCR0A = 249; // T = 4 us * (249 + 1) = 1 ms
+  TCCR0B |= (1<<CS01) | (1<<CS00); // Задаем предделитель = 64
+
+  sei(); // Включить глобальные прерывания (больше не выключаются)
+
+  while (1) {
+    uint8_t pressed = get_key_press();
+    if (pressed) {
+      PORTB ^= pressed >> BUTTONS_TO_LEDS_SHIFT; // Меняем значение на противоположное
+    }
+  }
+}
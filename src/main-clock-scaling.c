@@ -0,0 +1,239 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Динамическое изменение тактовой частоты через регистр CLKPR (Clock Prescale Register).
+ *
+ * Системный делитель делит частоту кварца (16 MHz) на 1, 2, 4 ... 256 (CLKPS3..0 = 0..8).
+ * Делитель меняется "на лету", но от частоты зависят все таймеры. Поэтому вместе с делителем
+ * пересчитываются предделители и регистры совпадения таймеров:
+ *
+ * - Timer0 (CTC) - счетчик миллисекунд. В каждой строке таблицы подобраны предделитель и OCR0A так,
+ *   чтобы период прерывания был целым числом миллисекунд (1 или 2 ms);
+ * - Timer1 (Input Capture) - приемник NEC. Длительности приводятся к единицам 0.5 us
+ *   сдвигом влево, поэтому константы TICKS_* из main-ir-receiver.c не меняются.
+ *
+ * | CLKPS | F_CPU     | Timer0         | ms за прерывание | Timer1 | 1 тик Timer1 | Сдвиг |
+ * |-------|-----------|----------------|------------------|--------|--------------|-------|
+ * | 0     | 16 MHz    | /64, OCR0A=249 | 1                | /8     | 0.5 us       | 0     |
+ * | 1     | 8 MHz     | /64, OCR0A=124 | 1                | /8     | 1 us         | 1     |
+ * | 2     | 4 MHz     | /64, OCR0A=124 | 2                | /8     | 2 us         | 2     |
+ * | 3     | 2 MHz     | /8,  OCR0A=249 | 1                | /1     | 0.5 us       | 0     |
+ * | 4     | 1 MHz     | /8,  OCR0A=124 | 1                | /1     | 1 us         | 1     |
+ *
+ * Ниже 1 MHz обработчик TIMER1_CAPT_vect (~150 тактов) не успевает за фронтами NEC (560 us),
+ * поэтому самый медленный режим в примере - 1 MHz.
+ *
+ * Потребление (ориентировочные значения по графику "Active Supply Current vs. Frequency" из datasheet ATmega328P,
+ * Vcc = 5V, без учета светодиодов и USB-UART на плате Arduino Nano; не измерено):
+ *
+ * | F_CPU  | Ток, mA | Производительность, MIPS | mA на MIPS |
+ * |--------|---------|--------------------------|------------|
+ * | 16 MHz | ~9.5    | 16                       | ~0.6       |
+ * | 8 MHz  | ~5.0    | 8                        | ~0.63      |
+ * | 4 MHz  | ~2.7    | 4                        | ~0.68      |
+ * | 2 MHz  | ~1.5    | 2                        | ~0.75      |
+ * | 1 MHz  | ~0.9    | 1                        | ~0.9       |
+ *
+ * Энергия на единицу работы почти не зависит от частоты (работу лучше выполнять быстро и засыпать),
+ * а в ожидании низкая частота снижает ток в разы.
+ *
+ * Программа. В ожидании работаем на 1 MHz и мигаем светодиодом PB5 раз в секунду.
+ * При получении команды NEC (адрес 0x00, команда 0x45) переходим на 16 MHz, выполняем "тяжелую" работу
+ * и возвращаемся на 1 MHz. Интервалы мигания и прием ИК-команд не зависят от текущей частоты.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/power.h>
+#include <util/atomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LED_PIN PB5 // PB5(D13)
+#define LED_WORK_PIN PD4 // PD4(D4), горит пока выполняется работа на 16 MHz
+#define IR_RECEIVER_PIN PB0 // ICP1/PB0(D8)
+
+#define CLOCK_DIV_FAST 0 // 16 MHz
+#define CLOCK_DIV_SLOW 4 // 1 MHz
+
+typedef struct {
+    uint8_t timer0_cs; // Биты CS02..CS00
+    uint8_t timer0_ocr; // OCR0A
+    uint8_t timer0_ms; // Миллисекунд за одно прерывание Timer0
+    uint8_t timer1_cs; // Биты CS12..CS10
+    uint8_t timer1_shift; // Сдвиг влево для перевода тиков Timer1 в единицы 0.5 us
+} clock_config_t;
+
+const clock_config_t CLOCK_CONFIGS[] = {
+    {.timer0_cs = (1<<CS01) | (1<<CS00), .timer0_ocr = 249, .timer0_ms = 1, .timer1_cs = (1<<CS11), .timer1_shift = 0},
+    {.timer0_cs = (1<<CS01) | (1<<CS00), .timer0_ocr = 124, .timer0_ms = 1, .timer1_cs = (1<<CS11), .timer1_shift = 1},
+    {.timer0_cs = (1<<CS01) | (1<<CS00), .timer0_ocr = 124, .timer0_ms = 2, .timer1_cs = (1<<CS11), .timer1_shift = 2},
+    {.timer0_cs = (1<<CS01), .timer0_ocr = 249, .timer0_ms = 1, .timer1_cs = (1<<CS10), .timer1_shift = 0},
+    {.timer0_cs = (1<<CS01), .timer0_ocr = 124, .timer0_ms = 1, .timer1_cs = (1<<CS10), .timer1_shift = 1},
+};
+
+#define CLOCK_CONFIGS_SIZE (sizeof(CLOCK_CONFIGS) / sizeof(CLOCK_CONFIGS[0]))
+
+volatile uint32_t count_ms;
+volatile uint8_t timer0_ms = 1;
+volatile uint8_t timer1_shift = 0;
+
+ISR(TIMER0_COMPA_vect) {
+    count_ms += timer0_ms;
+}
+
+uint32_t millis(void) {
+    uint32_t value;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        value = count_ms;
+    }
+    return value;
+}
+
+// --- Приемник NEC (см. main-ir-receiver.c), длительности в единицах 0.5 us ---
+#define TICKS_9MS    18000
+#define TICKS_4_5MS  9000
+#define TICKS_560US  1120
+#define TICKS_1690US 3380
+
+#define TOLERANCE_9MS   200
+#define TOLERANCE_4_5MS 200
+#define TOLERANCE_BIT   150
+
+volatile uint16_t ir_last_capture = 0;
+volatile uint8_t ir_counter = 0;
+volatile uint32_t ir_data = 0; // Адрес, ~адрес, команда, ~команда (младшим битом вперед)
+volatile bool ir_finished = false;
+
+void ir_reset(void) {
+    ir_last_capture = 0;
+    ir_counter = 0;
+    ir_data = 0;
+    ir_finished = false;
+    TCCR1B &= ~(1<<ICES1); // Захват по падающему фронту
+}
+
+static inline bool is_duration_match(uint16_t duration, uint16_t target, uint16_t tolerance) {
+    return (duration > (target - tolerance)) && (duration < (target + tolerance));
+}
+
+ISR(TIMER1_CAPT_vect) {
+    uint16_t current_capture = ICR1;
+    uint16_t duration = (uint16_t)(current_capture - ir_last_capture) << timer1_shift;
+    bool is_match;
+
+    if (ir_finished) {
+        return; // Ждем, пока main заберет команду
+    }
+
+    if (ir_counter == 0) {
+        is_match = true;
+    } else if (ir_counter == 1) {
+        is_match = is_duration_match(duration, TICKS_9MS, TOLERANCE_9MS);
+    } else if (ir_counter == 2) {
+        is_match = is_duration_match(duration, TICKS_4_5MS, TOLERANCE_4_5MS);
+    } else if (ir_counter % 2) { // Импульсы 560 us, включая завершающий (67)
+        is_match = is_duration_match(duration, TICKS_560US, TOLERANCE_BIT);
+        if (is_match && ir_counter == 67) {
+            ir_finished = true;
+            return;
+        }
+    } else { // Паузы, определяющие бит
+        bool is_bit_1 = is_duration_match(duration, TICKS_1690US, TOLERANCE_BIT + 150);
+        is_match = is_bit_1 || is_duration_match(duration, TICKS_560US, TOLERANCE_BIT);
+        if (is_bit_1) {
+            ir_data |= (uint32_t)1 << ((ir_counter - 4) / 2);
+        }
+    }
+
+    if (is_match) {
+        ir_last_capture = current_capture;
+        ir_counter++;
+        TCCR1B ^= (1<<ICES1); // Инвертируем фронт для следующего захвата
+    } else {
+        ir_reset();
+    }
+}
+
+// Меняет системный делитель и пересчитывает таймеры.
+// Прием ИК-команды, начатый до смены частоты, сбрасывается (длительности в разных единицах нельзя сравнивать).
+void clock_set(uint8_t clkps) {
+    if (clkps >= CLOCK_CONFIGS_SIZE) {
+        return;
+    }
+    const clock_config_t *config = &CLOCK_CONFIGS[clkps];
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // Новое значение CLKPR нужно записать в течение 4 тактов после установки CLKPCE. Две записи на C
+        // не гарантируют этого (например, при -O0), clock_prescale_set() делает их ассемблерной вставкой.
+        // clock_div_t: clock_div_1 = 0 ... clock_div_256 = 8 - те же значения CLKPS.
+        clock_prescale_set((clock_div_t)clkps);
+
+        TCCR0B = config->timer0_cs;
+        OCR0A = config->timer0_ocr;
+        if (TCNT0 > config->timer0_ocr) {
+            TCNT0 = 0; // Иначе таймер досчитает до 255 и миллисекунда растянется
+        }
+        timer0_ms = config->timer0_ms;
+
+        TCCR1B = (TCCR1B & ~((1<<CS12) | (1<<CS11) | (1<<CS10))) | config->timer1_cs;
+        timer1_shift = config->timer1_shift;
+        ir_reset();
+    }
+}
+
+volatile uint16_t heavy_work_result; // Результат сохраняется, иначе компилятор вправе удалить вызов чистой функции
+
+// "Тяжелая" работа, которую выгодно выполнить на максимальной частоте.
+uint16_t heavy_work(uint32_t data) {
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < 4096; i++) {
+        crc ^= (uint8_t)(data >> ((i % 4) * 8));
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+int main(void) {
+    DDRB |= (1<<LED_PIN);
+    DDRD |= (1<<LED_WORK_PIN);
+
+    TCCR0A = (1<<WGM01); // Задаем режим CTC для Timer0
+    TIMSK0 |= (1<<OCIE0A); // Включить прерывание при совпадении для Timer0
+
+    TCCR1A = 0;
+    TIMSK1 |= (1<<ICIE1); // Включение прерывания по захвату (Input Capture)
+
+    clock_set(CLOCK_DIV_SLOW);
+
+    sei();
+
+    uint32_t blink_finish = 0;
+
+    while (1) {
+        uint32_t now = millis();
+        if ((int32_t)(now - blink_finish) >= 0) {
+            PORTB ^= (1<<LED_PIN);
+            blink_finish = now + 500;
+        }
+
+        if (ir_finished) {
+            uint32_t data = ir_data;
+            uint8_t address = data & 0xFF;
+            uint8_t command = (data >> 16) & 0xFF;
+            bool is_valid = ((data >> 8) & 0xFF) == (uint8_t)~address && (data >> 24) == (uint8_t)~command;
+
+            if (is_valid && address == 0x00 && command == 0x45) {
+                PORTD |= (1<<LED_WORK_PIN);
+                clock_set(CLOCK_DIV_FAST);
+                heavy_work_result = heavy_work(data);
+                clock_set(CLOCK_DIV_SLOW);
+                PORTD &= ~(1<<LED_WORK_PIN);
+            } else {
+                ir_reset();
+            }
+        }
+    }
+}
@@ -0,0 +1,175 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Цикл событий с приоритетами (include/event_loop.h) и очереди SPSC (include/spsc_queue.h) вместо флагов
+ * `volatile bool` из main-external-interrupt.c и опроса счетчика миллисекунд из main-blink-timer.c.
+ *
+ * Источники событий (в порядке приоритета):
+ *  1. Кнопка (INT0/PD2/D2 на GND) - прерывание по любому фронту кладет в очередь время фронта, обработчик
+ *     запоминает время последнего. Нажатие засчитывается по уровню: обработчик тиков читает пин, когда
+ *     BUTTON_DEBOUNCE_MS фронтов не было, и переключает светодиод D13 (PB5), если уровень сменился на нажатый.
+ *     Дребезг и при нажатии, и при отпускании отсеивается без задержки _delay_ms(), которая останавливала бы
+ *     всю программу.
+ *  2. Тик Timer0 (1 ms) - обработчик двигает программные таймеры и мигает светодиодами D9..D11 (PB1..PB3),
+ *     как в main-blink-timer.c. Счетчик миллисекунд меняет только main, поэтому читать его можно без cli().
+ *
+ * Тики не кладутся в очередь: прерывание увеличивает 8-битный счетчик isr_ticks, а main считает обработанные
+ * в handled_ticks. Если main не успел забрать тики (например, был занят дольше 1 мс), разность счетчиков
+ * - сколько тиков ждет, и они обрабатываются подряд: время программных таймеров не отстает, пока main
+ * не занят дольше 255 мс.
+ *
+ * Бенчмарк при запуске: стоимость push и pop (очередь uint8_t) в тактах, измеряется Timer1 без предделителя
+ * на BENCHMARK_ITERATIONS вызовах за вычетом пустого цикла. Результат - в benchmark_push_cycles и
+ * benchmark_pop_cycles (смотреть в симуляторе или отладчике).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spsc_queue.h"
+#include "event_loop.h"
+
+#define LED_PIN PB5 // PB5(D13)
+#define LED_RED_PIN PB3 // PB3(D11)
+#define LED_YELLOW_PIN PB2 // PB2(D10)
+#define LED_GREEN_PIN PB1 // PB1(D9)
+#define BUTTON_PIN PD2 // INT0/PD2(D2)
+
+#define BUTTON_DEBOUNCE_MS 50
+
+SPSC_QUEUE(button_queue, uint16_t, 8) // Время фронта на кнопке (ms)
+
+volatile uint16_t isr_now_ms; // Время для отметок в прерываниях, пишет только TIMER0_COMPA_vect
+volatile uint8_t isr_ticks; // Тики Timer0 (по модулю 256), пишет только TIMER0_COMPA_vect
+uint8_t handled_ticks; // Обработанные тики, пишет только main
+uint16_t now_ms; // Время для main, пишет только обработчик тиков
+
+ISR(INT0_vect) {
+    button_queue_push(isr_now_ms);
+}
+
+ISR(TIMER0_COMPA_vect) {
+    isr_now_ms++;
+    isr_ticks++;
+}
+
+// --- Кнопка ---
+
+uint16_t button_edge_ms; // Последний фронт
+bool button_settling; // Был фронт, уровень еще не проверен
+bool button_pressed; // Подтвержденное состояние
+
+void button_handle(void) {
+    button_queue_pop(&button_edge_ms);
+    button_settling = true;
+}
+
+// Из обработчика тиков: уровень, стабильный BUTTON_DEBOUNCE_MS после последнего фронта, - новое состояние
+void button_debounce(void) {
+    // Фронт мог прийти раньше, чем обработаны все тики (now_ms отстает от isr_now_ms): разность со знаком
+    if (!button_settling || (int16_t)(now_ms - button_edge_ms) < BUTTON_DEBOUNCE_MS) {
+        return;
+    }
+    button_settling = false;
+    bool pressed = !(PIND & (1<<BUTTON_PIN));
+    if (pressed != button_pressed) {
+        button_pressed = pressed;
+        if (pressed) {
+            PORTB ^= (1<<LED_PIN);
+        }
+    }
+}
+
+// --- Программные таймеры ---
+
+typedef struct {
+    uint8_t pin;
+    uint16_t delay_ms;
+    uint16_t time_finish;
+} blinker_t;
+
+blinker_t blinkers[] = {
+    {.pin = LED_RED_PIN, .delay_ms = 300, .time_finish = 300},
+    {.pin = LED_YELLOW_PIN, .delay_ms = 500, .time_finish = 500},
+    {.pin = LED_GREEN_PIN, .delay_ms = 1000, .time_finish = 1000},
+};
+
+void tick_handle(void) {
+    handled_ticks++;
+    now_ms++;
+    button_debounce();
+    for (uint8_t i = 0; i < sizeof(blinkers) / sizeof(blinkers[0]); i++) {
+        blinker_t *blinker = &blinkers[i];
+        if (now_ms == blinker->time_finish) {
+            PORTB ^= (1<<blinker->pin);
+            blinker->time_finish = now_ms + blinker->delay_ms;
+        }
+    }
+}
+
+bool button_pending(void) {
+    return !button_queue_empty();
+}
+
+bool tick_pending(void) {
+    return isr_ticks != handled_ticks; // 8 бит читаются атомарно
+}
+
+const event_source_t SOURCES[] = {
+    {.pending = button_pending, .handle = button_handle},
+    {.pending = tick_pending, .handle = tick_handle},
+};
+
+// --- Бенчмарк ---
+
+#define BENCHMARK_ITERATIONS 8 // Очередь на 16 элементов: 8 push подряд без переполнения
+
+SPSC_QUEUE(benchmark_queue, uint8_t, 16)
+
+volatile uint8_t benchmark_push_cycles;
+volatile uint8_t benchmark_pop_cycles;
+
+// Такты на BENCHMARK_ITERATIONS вызовов op (цикл развернут компилятором не будет: счетчик volatile)
+#define BENCHMARK(op) ({ \
+    uint16_t start = TCNT1; \
+    for (volatile uint8_t i = 0; i < BENCHMARK_ITERATIONS; i++) { \
+        op; \
+    } \
+    (uint16_t)(TCNT1 - start); \
+})
+
+void benchmark(void) {
+    TCCR1A = 0;
+    TCCR1B = (1<<CS10); // Без предделителя: 1 тик = 1 такт
+
+    uint8_t value = 0;
+    uint16_t empty = BENCHMARK(__asm__ __volatile__("" ::: "memory"));
+    uint16_t push = BENCHMARK(benchmark_queue_push(value));
+    uint16_t pop = BENCHMARK(benchmark_queue_pop(&value));
+
+    benchmark_push_cycles = (push - empty) / BENCHMARK_ITERATIONS;
+    benchmark_pop_cycles = (pop - empty) / BENCHMARK_ITERATIONS;
+
+    TCCR1B = 0;
+}
+
+int main(void) {
+    benchmark();
+
+    DDRB |= (1<<LED_PIN) | (1<<LED_RED_PIN) | (1<<LED_YELLOW_PIN) | (1<<LED_GREEN_PIN); // Настраиваем пины на выход
+
+    PORTD |= (1<<BUTTON_PIN); // Подтягиваем INT0/PD2(D2) к HIGH
+    EICRA |= (1<<ISC00); // Прерывание INT0 по любому фронту (ISC01=0, ISC00=1)
+    EIMSK |= (1<<INT0);
+
+    TIMSK0 |= (1<<OCIE0A); // Включить прерывание при совпадении для Timer0
+    TCCR0A |= (1<<WGM01); // Задаем режим CTC для Timer0
+    OCR0A = 249; // 250 тиков по 4 us = 1 ms
+    TCCR0B |= (1<<CS01) | (1<<CS00); // Задаем предделитель = 64
+
+    sei(); // Разрешаем прерывания
+
+    event_loop_run(SOURCES, sizeof(SOURCES) / sizeof(SOURCES[0]));
+}
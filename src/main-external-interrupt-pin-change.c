@@ -10,23 +10,79 @@
  * - PCI2 - пины PCINT[23:16];
  * 
  * Программа. Будем включать и выключать светодиод при нажатии на кнопку.
+ *
+ * Как в main-external-interrupt.c: прерывание кладет время фронта в очередь, цикл событий проверяет уровень,
+ * когда BUTTON_DEBOUNCE_MS фронтов не было.
  */
 
 #include <avr/io.h>
-#include <util/delay.h>
 #include <avr/interrupt.h>
+#include <stdint.h>
 #include <stdbool.h>
 
+#include "spsc_queue.h"
+#include "event_loop.h"
+
 #define LED_PIN PB5 // D13
 #define BUTTON_PIN PB0 // PCINT0/PB0 (D8)
 
-volatile bool is_interrupt_button = false;
+#define BUTTON_DEBOUNCE_MS 50
+
+SPSC_QUEUE(button_queue, uint16_t, 8) // Время фронта на кнопке (ms)
+
+volatile uint16_t isr_now_ms; // Время для отметок в прерываниях, пишет только TIMER0_COMPA_vect
+volatile uint8_t isr_ticks; // Тики Timer0 (по модулю 256), пишет только TIMER0_COMPA_vect
+uint8_t handled_ticks; // Обработанные тики, пишет только main
+uint16_t now_ms; // Время для main, пишет только обработчик тиков
 
 ISR(PCINT0_vect) {
-  cli(); // Выключить глобальные прерывания
-  is_interrupt_button = true;
+  button_queue_push(isr_now_ms);
+}
+
+ISR(TIMER0_COMPA_vect) {
+  isr_now_ms++;
+  isr_ticks++;
+}
+
+uint16_t button_edge_ms; // Последний фронт
+bool button_settling; // Был фронт, уровень еще не проверен
+bool button_pressed; // Подтвержденное состояние
+
+bool button_pending(void) {
+  return !button_queue_empty();
+}
+
+void button_handle(void) {
+  button_queue_pop(&button_edge_ms);
+  button_settling = true;
+}
+
+bool tick_pending(void) {
+  return isr_ticks != handled_ticks; // 8 бит читаются атомарно
 }
 
+void tick_handle(void) {
+  handled_ticks++;
+  now_ms++;
+  // Фронт мог прийти раньше, чем обработаны все тики (now_ms отстает от isr_now_ms): разность со знаком
+  if (!button_settling || (int16_t)(now_ms - button_edge_ms) < BUTTON_DEBOUNCE_MS) {
+    return;
+  }
+  button_settling = false;
+  bool pressed = !(PINB & (1<<BUTTON_PIN));
+  if (pressed != button_pressed) {
+    button_pressed = pressed;
+    if (pressed) {
+      PORTB ^= (1<<LED_PIN); // Меняем значение на противоположное
+    }
+  }
+}
+
+const event_source_t SOURCES[] = {
+  {.pending = button_pending, .handle = button_handle},
+  {.pending = tick_pending, .handle = tick_handle},
+};
+
 int main(void) {
   DDRB |= (1<<LED_PIN); // Настройка PB5 на выход
 
@@ -36,14 +92,12 @@ int main(void) {
   PCICR |= (1<<PCIE0); // Разрешить прерывания на группе контактов PCIE0
   PCMSK0 |= (1<<PCINT0); // Разрешить прерывание на PCINT0
 
+  TIMSK0 |= (1<<OCIE0A); // Включить прерывание при совпадении для Timer0
+  TCCR0A |= (1<<WGM01); // Задаем режим CTC для Timer0
+  OCR0A = 249; // 250 тиков по 4 us = 1 ms
+  TCCR0B |= (1<<CS01) | (1<<CS00); // Задаем предделитель = 64
+
   sei(); // Включить глобальные прерывания
 
-  while (1) {
-    if (is_interrupt_button) {
-      PORTB ^= (1<<LED_PIN); // Меняем значение на противоположное
-      _delay_ms(1000); // Для борьбы с дребезгом кнопки
-      sei(); // Включить глобальные прерывания
-      is_interrupt_button = false;
-    }
-  }
-}
\ No newline at end of file
+  event_loop_run(SOURCES, sizeof(SOURCES) / sizeof(SOURCES[0]));
+}
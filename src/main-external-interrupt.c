@@ -9,23 +9,81 @@
  * INT1/PD3(D3)
  * 
  * Программа. Будем включать и выключать светодиод при нажатии на кнопку.
+ *
+ * Прерывание только кладет время фронта в очередь (include/spsc_queue.h), а обработку выполняет цикл событий
+ * (include/event_loop.h), как в main-event-loop.c. Дребезг отсеивается по уровню: когда BUTTON_DEBOUNCE_MS
+ * после последнего фронта новых фронтов не было, обработчик тиков Timer0 читает пин. Прерывания не
+ * выключаются, и программа не стоит в _delay_ms(), пока кнопка дребезжит.
  */
 
 #include <avr/io.h>
-#include <util/delay.h>
 #include <avr/interrupt.h>
+#include <stdint.h>
 #include <stdbool.h>
 
+#include "spsc_queue.h"
+#include "event_loop.h"
+
 #define LED_PIN PB5 // D13
 #define BUTTON_PIN PD2 // INT0/PD2(D2)
 
-volatile bool is_interrupt_button = false;
+#define BUTTON_DEBOUNCE_MS 50
+
+SPSC_QUEUE(button_queue, uint16_t, 8) // Время фронта на кнопке (ms)
+
+volatile uint16_t isr_now_ms; // Время для отметок в прерываниях, пишет только TIMER0_COMPA_vect
+volatile uint8_t isr_ticks; // Тики Timer0 (по модулю 256), пишет только TIMER0_COMPA_vect
+uint8_t handled_ticks; // Обработанные тики, пишет только main
+uint16_t now_ms; // Время для main, пишет только обработчик тиков
 
 ISR(INT0_vect) {
-  cli(); // Выключить глобальные прерывания
-  is_interrupt_button = true;
+  button_queue_push(isr_now_ms);
+}
+
+ISR(TIMER0_COMPA_vect) {
+  isr_now_ms++;
+  isr_ticks++;
+}
+
+uint16_t button_edge_ms; // Последний фронт
+bool button_settling; // Был фронт, уровень еще не проверен
+bool button_pressed; // Подтвержденное состояние
+
+bool button_pending(void) {
+  return !button_queue_empty();
+}
+
+void button_handle(void) {
+  button_queue_pop(&button_edge_ms);
+  button_settling = true;
+}
+
+bool tick_pending(void) {
+  return isr_ticks != handled_ticks; // 8 бит читаются атомарно
 }
 
+void tick_handle(void) {
+  handled_ticks++;
+  now_ms++;
+  // Фронт мог прийти раньше, чем обработаны все тики (now_ms отстает от isr_now_ms): разность со знаком
+  if (!button_settling || (int16_t)(now_ms - button_edge_ms) < BUTTON_DEBOUNCE_MS) {
+    return;
+  }
+  button_settling = false;
+  bool pressed = !(PIND & (1<<BUTTON_PIN));
+  if (pressed != button_pressed) {
+    button_pressed = pressed;
+    if (pressed) {
+      PORTB ^= (1<<LED_PIN); // Меняем значение на противоположное
+    }
+  }
+}
+
+const event_source_t SOURCES[] = {
+  {.pending = button_pending, .handle = button_handle},
+  {.pending = tick_pending, .handle = tick_handle},
+};
+
 int main(void) {
   DDRB |= (1<<LED_PIN); // Настройка PB5 на выход
 
@@ -37,18 +95,16 @@ int main(void) {
   // 01 - генерировать прерывание при изменении значения (с LOW на HIGH и наоборот)
   // 10 - генерировать прерывание при изменении значения с HIGH на LOW
   // 11 - генерировать прерывание при изменении значения с LOW на HIGH
-  EICRA |= (1<<ISC01); // (ISC01=1, ISC00=0)
+  EICRA |= (1<<ISC00); // (ISC01=0, ISC00=1): дребезг отсеивается и при нажатии, и при отпускании
 
   EIMSK |= (1<<INT0); // Разрешить прерывания на INT0
 
+  TIMSK0 |= (1<<OCIE0A); // Включить прерывание при совпадении для Timer0
+  TCCR0A |= (1<<WGM01); // Задаем режим CTC для Timer0
+  OCR0A = 249; // 250 тиков по 4 us = 1 ms
+  TCCR0B |= (1<<CS01) | (1<<CS00); // Задаем предделитель = 64
+
   sei(); // Включить глобальные прерывания
 
-  while (1) {
-    if (is_interrupt_button) {
-      PORTB ^= (1<<LED_PIN); // Меняем значение на противоположное
-      _delay_ms(1000); // Для борьбы с дребезгом кнопки
-      sei(); // Включить глобальные прерывания
-      is_interrupt_button = false;
-    }
-  }
-}
\ No newline at end of file
+  event_loop_run(SOURCES, sizeof(SOURCES) / sizeof(SOURCES[0]));
+}
@@ -0,0 +1,234 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Частотомер и измеритель периода от ~0.1 Hz до ~4 MHz с автоматическим выбором режима.
+ * Сигнал (0..5 V) подается одновременно на ICP1/PB0(D8) и T1/PD5(D5) (перемычка между D8 и D5).
+ * Результаты передаются по USART (1 000 000 бод, 8N1) раз в GATE_MS (на низких частотах - раз в период).
+ *
+ * Режим захвата (низкие частоты, до CAPTURE_MAX_HZ):
+ *  Timer1 считает такты без предделителя (62.5 ns), каждый фронт на ICP1 сохраняет TCNT1 в ICR1.
+ *  Переполнения Timer1 считаются в TIMER1_OVF_vect - время фронта 32-битное (до 268 s).
+ *  Частота считается обратным методом (reciprocal): f = (фронтов - 1) / (время последнего - время первого фронта)
+ *  по всем фронтам за окно не короче GATE_MS. Разрешение - 62.5 ns на окно независимо от частоты сигнала,
+ *  поэтому на низких частотах точность намного выше, чем при подсчете фронтов за фиксированное время.
+ *  Окна идут подряд без пропусков: последний фронт окна - первый фронт следующего.
+ *
+ * Режим счета (высокие частоты, выше COUNT_MIN_HZ):
+ *  Timer1 тактируется внешним сигналом T1 (по фронту), Timer2 отмеряет окно GATE_MS от системной частоты.
+ *  f = фронтов за окно / GATE_MS. Разрешение ±1 фронт за окно (±10 Hz при 100 ms). Внешний тактовый сигнал
+ *  синхронизируется с системным, поэтому частота на T1 должна быть меньше F_CPU / 2.5 (6.4 MHz, даташит);
+ *  с запасом на скважность и фронты сигнала - до ~4 MHz.
+ *
+ * Переключение режимов - с гистерезисом, чтобы частота около порога не вызывала постоянных переключений:
+ * захват -> счет при частоте выше CAPTURE_MAX_HZ, счет -> захват при частоте ниже COUNT_MIN_HZ.
+ *
+ * Бюджет прерываний (оценка вручную по числу инструкций, с прологом и эпилогом; листингом не проверена):
+ *  - TIMER1_CAPT_vect ~ 60 тактов на фронт. При CAPTURE_MAX_HZ = 20 kHz это ~1.2 млн тактов/с, то есть
+ *    ~7.5% процессора. Если частота резко выросла, захват отключается после CAPTURE_EDGES_MAX фронтов в окне,
+ *    так что шквал фронтов не может занять процессор дольше одного окна. Такое окно не публикуется: при шквале
+ *    TIMER1_CAPT_vect (приоритет выше) не дает выполниться TIMER1_OVF_vect, и время фронтов недостоверно;
+ *  - TIMER1_OVF_vect ~ 30 тактов, 244 раза в секунду в режиме захвата;
+ *  - TIMER2_COMPA_vect (1 ms) ~ 40 тактов, раз в GATE_MS - до ~200 тактов (публикация, смена режима).
+ *
+ * Прерывания не ждут main: результат окна кладется в очередь (include/spsc_queue.h), main забирает его,
+ * считает частоту и период (деление 64-битных целых) и печатает. Если main не успевает, результаты
+ * отбрасываются и считаются в measurements.dropped.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spsc_queue.h"
+#include "usart_polled.h"
+
+#define GATE_MS 100 // Минимальная длина окна
+#define TIMEOUT_MS 12000 // Нет фронтов дольше - частота 0 (ниже ~0.08 Hz)
+#define CAPTURE_MAX_HZ 20000
+#define COUNT_MIN_HZ 10000
+#define CAPTURE_EDGES_MAX (2 * CAPTURE_MAX_HZ / (1000 / GATE_MS)) // Фронтов в окне, после которых захват отключается
+
+#define GATE_CYCLES ((uint32_t)(F_CPU / 1000) * GATE_MS)
+
+typedef enum {
+    MODE_CAPTURE,
+    MODE_COUNT,
+} meter_mode_t;
+
+typedef struct {
+    uint8_t mode;
+    uint32_t edges; // Периодов сигнала в окне
+    uint32_t cycles; // Длина окна в тактах F_CPU
+} measurement_t;
+
+SPSC_QUEUE(measurements, measurement_t, 4)
+
+meter_mode_t meter_mode;
+uint16_t meter_overflows; // Старшие 16 бит времени (захват) или счетчика фронтов (счет)
+uint16_t meter_gate_ms;
+
+// Режим захвата
+uint16_t meter_captures; // Фронтов в окне, включая первый
+uint32_t meter_first;
+uint32_t meter_last;
+
+// Режим счета
+uint32_t meter_count_last;
+
+void meter_start_capture(void) {
+    TIMSK1 = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    TIFR1 = (1<<ICF1) | (1<<TOV1);
+    meter_overflows = 0;
+    meter_captures = 0;
+    meter_gate_ms = 0;
+    meter_mode = MODE_CAPTURE;
+    TIMSK1 = (1<<ICIE1) | (1<<TOIE1);
+    TCCR1B = (1<<ICES1) | (1<<CS10); // Захват по фронту, без предделителя
+}
+
+void meter_start_count(void) {
+    TIMSK1 = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    TIFR1 = (1<<ICF1) | (1<<TOV1);
+    meter_overflows = 0;
+    meter_count_last = 0;
+    meter_gate_ms = 0;
+    meter_mode = MODE_COUNT;
+    TIMSK1 = (1<<TOIE1);
+    TCCR1B = (1<<CS12) | (1<<CS11) | (1<<CS10); // Внешний сигнал T1, по фронту
+}
+
+// Старшая часть 32-битного значения для младшей части low, прочитанной в прерывании.
+// Если Timer1 переполнился, а TIMER1_OVF_vect еще не выполнен (выполняется обработчик с более высоким
+// приоритетом), флаг TOV1 уже поднят: маленькое low значит, что оно прочитано после переполнения.
+static inline uint16_t meter_high(uint16_t low) {
+    uint16_t high = meter_overflows;
+    if ((TIFR1 & (1<<TOV1)) && low < 0x8000) {
+        high++;
+    }
+    return high;
+}
+
+ISR(TIMER1_CAPT_vect) {
+    uint16_t capture = ICR1;
+    uint32_t time = ((uint32_t)meter_high(capture) << 16) | capture;
+    if (meter_captures == 0) {
+        meter_first = time;
+        meter_gate_ms = 0; // Тайм-аут отсчитывается от первого фронта
+    }
+    meter_last = time;
+    if (++meter_captures >= CAPTURE_EDGES_MAX) {
+        TIMSK1 &= ~(1<<ICIE1); // Частота слишком высокая для захвата: ждем конца окна и смены режима
+    }
+}
+
+ISR(TIMER1_OVF_vect) {
+    meter_overflows++;
+}
+
+static void meter_gate_capture(void) {
+    if (!(TIMSK1 & (1<<ICIE1))) {
+        meter_start_count(); // Захват отключен шквалом фронтов: результат окна недостоверен
+        return;
+    }
+    if (meter_captures >= 2 && meter_gate_ms >= GATE_MS) {
+        uint32_t edges = meter_captures - 1;
+        uint32_t cycles = meter_last - meter_first;
+        measurements_push((measurement_t){.mode = MODE_CAPTURE, .edges = edges, .cycles = cycles});
+
+        // edges / cycles * F_CPU > CAPTURE_MAX_HZ без 64-битного умножения: edges не больше CAPTURE_EDGES_MAX
+        if (edges * (F_CPU / CAPTURE_MAX_HZ) > cycles) {
+            meter_start_count();
+            return;
+        }
+        meter_first = meter_last; // Следующее окно начинается с последнего фронта этого
+        meter_captures = 1;
+        meter_gate_ms = 0;
+    } else if (meter_gate_ms >= TIMEOUT_MS) {
+        measurements_push((measurement_t){.mode = MODE_CAPTURE, .edges = 0, .cycles = 0});
+        meter_captures = 0;
+        meter_gate_ms = 0;
+    }
+}
+
+static void meter_gate_count(void) {
+    if (meter_gate_ms < GATE_MS) {
+        return;
+    }
+    meter_gate_ms = 0;
+
+    uint16_t low = TCNT1;
+    uint32_t count = ((uint32_t)meter_high(low) << 16) | low;
+    uint32_t edges = count - meter_count_last;
+    meter_count_last = count;
+    measurements_push((measurement_t){.mode = MODE_COUNT, .edges = edges, .cycles = GATE_CYCLES});
+
+    if (edges < (uint32_t)COUNT_MIN_HZ * GATE_MS / 1000) {
+        meter_start_capture();
+    }
+}
+
+// Timer2: окно измерения, 1 ms. Приоритет выше, чем у прерываний Timer1.
+ISR(TIMER2_COMPA_vect) {
+    if (meter_gate_ms < 0xFFFF) {
+        meter_gate_ms++;
+    }
+    if (meter_mode == MODE_CAPTURE) {
+        meter_gate_capture();
+    } else {
+        meter_gate_count();
+    }
+}
+
+// Число с тремя знаками после запятой: value - в тысячных долях
+void usart_print_milli_blocking(uint64_t value) {
+    usart_print_uint_blocking(value / 1000);
+    usart_print_blocking(".");
+    uint16_t fraction = value % 1000;
+    usart_print_blocking(fraction < 100 ? (fraction < 10 ? "00" : "0") : "");
+    usart_print_uint_blocking(fraction);
+}
+
+void print_measurement(const measurement_t *measurement) {
+    usart_print_blocking(measurement->mode == MODE_CAPTURE ? "capture " : "count   ");
+    if (measurement->edges == 0) {
+        usart_print_blocking("f=0 Hz\r\n");
+        return;
+    }
+    // f (mHz) = edges * F_CPU * 1000 / cycles, T (ns) = cycles * 10^9 / (F_CPU * edges)
+    uint64_t millihertz = ((uint64_t)measurement->edges * F_CPU * 1000 + measurement->cycles / 2) / measurement->cycles;
+    uint64_t period_ns = ((uint64_t)measurement->cycles * 1000000000ULL + (uint64_t)F_CPU * measurement->edges / 2)
+        / ((uint64_t)F_CPU * measurement->edges);
+    usart_print_blocking("f=");
+    usart_print_milli_blocking(millihertz);
+    usart_print_blocking(" Hz T=");
+    usart_print_milli_blocking(period_ns); // Наносекунды в тысячных - микросекунды
+    usart_print_blocking(" us edges=");
+    usart_print_uint_blocking(measurement->edges);
+    usart_print_blocking("\r\n");
+}
+
+int main(void) {
+    // ICP1/PB0 и T1/PD5 - входы по умолчанию
+    usart_init(false);
+
+    // Timer2: CTC, предделитель 64, 250 тиков по 4 us = 1 ms
+    TCCR2A = (1<<WGM21);
+    OCR2A = 249;
+    TIMSK2 = (1<<OCIE2A);
+    TCCR2B = (1<<CS22);
+
+    meter_start_capture();
+    sei();
+
+    while (1) {
+        measurement_t measurement;
+        if (measurements_pop(&measurement)) {
+            print_measurement(&measurement);
+        }
+    }
+}
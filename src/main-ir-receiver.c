@@ -39,12 +39,13 @@
  * - Инвертированная команда: 0xBA (передается как 10111010)
  */
 
-#include <avr/io.h>
-#include <util/delay.h>
-#include <avr/interrupt.h>
+#include "hal.h"
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "spsc_queue.h"
+#include "event_loop.h"
+
 #define LED_PIN PD4 // PD4(D4)
 #define IR_RECEIVER_PIN PB0 // ICP1/PB0(D8)
 
@@ -65,14 +66,23 @@ volatile uint16_t ir_last_capture = 0;
 volatile uint8_t ir_counter = 0;
 volatile uint8_t ir_address = 0;
 volatile uint8_t ir_command = 0;
-volatile bool ir_finished = false;
+
+// Принятые посылки передаются из прерывания в main через очередь (источник событий для event_loop.h):
+// декодер сразу готов к следующей посылке, и посылки, пришедшие подряд, не теряются, пока main занят.
+// Между посылками цикл событий спит в режиме Idle. Короткие посылки повтора NEC при удержании кнопки
+// (9 мс + пауза 2.25 мс) декодер не принимает: они отбрасываются на паузе после стартового импульса
+typedef struct {
+  uint8_t address;
+  uint8_t command;
+} ir_frame_t;
+
+SPSC_QUEUE(ir_frames, ir_frame_t, 8)
 
 void ir_reset() {
   ir_last_capture = 0;
   ir_counter = 0;
   ir_address = 0;
   ir_command = 0;
-  ir_finished = false;
 
   // Захват по падающему фронту (ICES1 = 0) для обнаружения стартового импульса.
   TCCR1B &= ~(1 << ICES1);
@@ -164,11 +174,9 @@ ISR(TIMER1_CAPT_vect) {
     // Завершающий импульс
     case 67:
       if (is_duration_match(duration_ticks, TICKS_560US, TOLERANCE_BIT)) {
-        ir_finished = true;
-      } else {
-        ir_reset();
+        ir_frames_push((ir_frame_t){.address = ir_address, .command = ir_command});
       }
-      // Не переключаем фронт, ждем сброса в main
+      ir_reset();
       break;
 
     default:
@@ -181,6 +189,24 @@ void led_invert() {
   PORTD ^= (1 << LED_PIN);
 }
 
+bool ir_frame_pending(void) {
+  return !ir_frames_empty();
+}
+
+void ir_frame_handle(void) {
+  ir_frame_t frame;
+  ir_frames_pop(&frame);
+  // Проверка инвертированных байтов выполняется в прерывании.
+  // Если адрес 0x00 и команда 0x45 (кнопка Power на многих пультах)
+  if (frame.address == 0x00 && frame.command == 0x45) {
+    led_invert();
+  }
+}
+
+const event_source_t SOURCES[] = {
+  {.pending = ir_frame_pending, .handle = ir_frame_handle},
+};
+
 int main(void) {
   // Настройка LED_PIN на выход
   DDRD |= (1 << LED_PIN);
@@ -199,16 +225,5 @@ int main(void) {
   // Включить глобальные прерывания
   sei();
 
-  while (1) {
-    if (ir_finished) {
-      // Проверка инвертированных байтов теперь выполняется в прерывании.
-      // Если адрес 0x00 и команда 0x45 (кнопка Power на многих пультах)
-      if (ir_address == 0x00 && ir_command == 0x45) {
-        led_invert();
-      }
-      
-      // Сбрасываем состояние для приема следующей команды
-      ir_reset();
-    }
-  }
+  event_loop_run(SOURCES, sizeof(SOURCES) / sizeof(SOURCES[0]));
 }
@@ -0,0 +1,205 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Измерение задержки входа и длительности обработчиков прерываний (см. include/isr_profiler.h).
+ *
+ * Обработчики объявлены через ISR_PROFILED() вместо ISR(). В окружении isr-profiler (флаг ISR_PROFILER)
+ * каждый вызов добавляет задержку входа и длительность в гистограммы. Без флага (например, если собрать
+ * этот файл с build_flags без -D ISR_PROFILER) код профилировщика в прошивку не попадает.
+ *
+ * Timer1 работает в режиме Normal с предделителем 8 (1 тик = 0.5 us) и используется сразу для трех задач:
+ * - TIMER1_COMPA_vect - периодическая задача каждую 1 ms (OCR1A += 2000), задержка считается от OCR1A;
+ * - TIMER1_CAPT_vect - прием команд NEC (как в main-ir-receiver.c), задержка считается от ICR1;
+ * - TIMER0_COMPA_vect - счетчик миллисекунд на Timer0, момент события по Timer1 неизвестен (только длительность).
+ *
+ * Программа. При получении символа 'p' по USART (1 000 000 бод) печатает отчет и обнуляет гистограммы:
+ *  timer1_compa: 1000 calls
+ *    latency  max 9: [4..7] 812 [8..15] 188
+ *    duration max 3: [2..3] 1000
+ * Значения в тиках Timer1 (0.5 us). Корзина [a..b] - количество вызовов со значением от a до b.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "isr_profiler.h"
+#include "usart_polled.h"
+
+#define LED_PIN PD4 // PD4(D4)
+#define IR_RECEIVER_PIN PB0 // ICP1/PB0(D8)
+
+#define PROFILE_TIMER1_COMPA 0
+#define PROFILE_TIMER1_CAPT 1
+#define PROFILE_TIMER0_COMPA 2
+
+#define TIMER1_PERIOD_TICKS 2000 // 1 ms
+
+// --- Периодическая задача на Timer1 ---
+
+volatile uint16_t periodic_counter;
+
+ISR_PROFILED(TIMER1_COMPA_vect, PROFILE_TIMER1_COMPA, OCR1A) {
+    OCR1A += TIMER1_PERIOD_TICKS; // Следующее срабатывание ровно через 1 ms от запланированного (без накопления ошибки)
+    periodic_counter++;
+}
+
+// --- Прием команд NEC (см. main-ir-receiver.c) ---
+
+#define TICKS_9MS    18000
+#define TICKS_4_5MS  9000
+#define TICKS_560US  1120
+#define TICKS_1690US 3380
+
+#define TOLERANCE_9MS   200
+#define TOLERANCE_4_5MS 200
+#define TOLERANCE_BIT   150
+
+volatile uint16_t ir_last_capture = 0;
+volatile uint8_t ir_counter = 0;
+volatile uint32_t ir_data = 0;
+volatile bool ir_finished = false;
+
+void ir_reset(void) {
+    ir_last_capture = 0;
+    ir_counter = 0;
+    ir_data = 0;
+    ir_finished = false;
+    TCCR1B &= ~(1<<ICES1); // Захват по падающему фронту
+}
+
+static inline bool is_duration_match(uint16_t duration, uint16_t target, uint16_t tolerance) {
+    return (duration > (target - tolerance)) && (duration < (target + tolerance));
+}
+
+ISR_PROFILED(TIMER1_CAPT_vect, PROFILE_TIMER1_CAPT, ICR1) {
+    uint16_t current_capture = ICR1;
+    uint16_t duration = current_capture - ir_last_capture;
+    bool is_match;
+
+    if (ir_finished) {
+        return;
+    }
+
+    if (ir_counter == 0) {
+        is_match = true;
+    } else if (ir_counter == 1) {
+        is_match = is_duration_match(duration, TICKS_9MS, TOLERANCE_9MS);
+    } else if (ir_counter == 2) {
+        is_match = is_duration_match(duration, TICKS_4_5MS, TOLERANCE_4_5MS);
+    } else if (ir_counter % 2) {
+        is_match = is_duration_match(duration, TICKS_560US, TOLERANCE_BIT);
+        if (is_match && ir_counter == 67) {
+            ir_finished = true;
+            return;
+        }
+    } else {
+        bool is_bit_1 = is_duration_match(duration, TICKS_1690US, TOLERANCE_BIT + 150);
+        is_match = is_bit_1 || is_duration_match(duration, TICKS_560US, TOLERANCE_BIT);
+        if (is_bit_1) {
+            ir_data |= (uint32_t)1 << ((ir_counter - 4) / 2);
+        }
+    }
+
+    if (is_match) {
+        ir_last_capture = current_capture;
+        ir_counter++;
+        TCCR1B ^= (1<<ICES1);
+    } else {
+        ir_reset();
+    }
+}
+
+// --- Счетчик миллисекунд на Timer0 ---
+
+volatile uint32_t count_ms;
+
+ISR_PROFILED_NO_LATENCY(TIMER0_COMPA_vect, PROFILE_TIMER0_COMPA) {
+    count_ms++;
+}
+
+#ifdef ISR_PROFILER
+
+void print_histogram(const char *name, const uint16_t *histogram, uint16_t max) {
+    usart_print_blocking(name);
+    usart_print_blocking(" max ");
+    usart_print_uint_blocking(max);
+    usart_print_blocking(":");
+    for (uint8_t bucket = 0; bucket < ISR_PROFILER_BUCKETS; bucket++) {
+        if (histogram[bucket]) {
+            uint32_t low = bucket ? 1UL << (bucket - 1) : 0;
+            uint32_t high = bucket ? (1UL << bucket) - 1 : 0;
+            usart_print_blocking(" [");
+            usart_print_uint_blocking(low);
+            usart_print_blocking("..");
+            usart_print_uint_blocking(high);
+            usart_print_blocking("] ");
+            usart_print_uint_blocking(histogram[bucket]);
+        }
+    }
+    usart_print_blocking("\r\n");
+}
+
+void print_profile(const char *name, uint8_t id, bool has_latency) {
+    isr_profile_t profile;
+    isr_profile_take(id, &profile);
+
+    usart_print_blocking(name);
+    usart_print_blocking(": ");
+    usart_print_uint_blocking(profile.count);
+    usart_print_blocking(" calls\r\n");
+    if (has_latency) {
+        print_histogram("  latency ", profile.latency, profile.latency_max);
+    }
+    print_histogram("  duration", profile.duration, profile.duration_max);
+}
+
+void print_report(void) {
+    print_profile("timer1_compa", PROFILE_TIMER1_COMPA, true);
+    print_profile("timer1_capt", PROFILE_TIMER1_CAPT, true);
+    print_profile("timer0_compa", PROFILE_TIMER0_COMPA, false);
+}
+
+#else
+
+void print_report(void) {
+    usart_print_blocking("ISR profiler is disabled (build with -D ISR_PROFILER)\r\n");
+}
+
+#endif
+
+int main(void) {
+    DDRD |= (1<<LED_PIN);
+
+    usart_init(true);
+
+    TCCR1A = 0;
+    TCCR1B = (1<<CS11); // Normal, предделитель 8 (0.5 us/тик)
+    OCR1A = TIMER1_PERIOD_TICKS;
+    TIMSK1 |= (1<<ICIE1) | (1<<OCIE1A);
+    ir_reset();
+
+    TCCR0A = (1<<WGM01); // Timer0 CTC, 1 ms
+    OCR0A = 249;
+    TIMSK0 = (1<<OCIE0A);
+    TCCR0B = (1<<CS01) | (1<<CS00);
+
+    sei();
+
+    while (1) {
+        if (ir_finished) {
+            uint32_t data = ir_data;
+            uint8_t address = data & 0xFF;
+            uint8_t command = (data >> 16) & 0xFF;
+            if (((data >> 8) & 0xFF) == (uint8_t)~address && (data >> 24) == (uint8_t)~command
+                    && address == 0x00 && command == 0x45) {
+                PORTD ^= (1<<LED_PIN);
+            }
+            ir_reset();
+        }
+
+        if (usart_read() == 'p') {
+            print_report();
+        }
+    }
+}
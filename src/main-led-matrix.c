@@ -0,0 +1,218 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Динамическая индикация: светодиодная матрица 8x8 или 4-разрядный 7-сегментный индикатор.
+ * Обновление - в прерывании Timer2, main только рисует кадры.
+ *
+ * В main-adc.c каждый светодиод подключен к своему пину. Матрице 8x8 понадобилось бы 64 пина, поэтому светодиоды
+ * включаются по строкам: 8 пинов столбцов (сегментов) общие, строки (разряды) включаются по очереди,
+ * и глаз видит все строки одновременно, если кадр обновляется чаще ~100 Hz.
+ *
+ * Подключение:
+ *  - столбцы (сегменты a..g, dp) - PORTD: PD0(D0)..PD7(D7) через резисторы 220 Ом;
+ *  - строки (общие катоды разрядов) - через NPN транзисторы (ток строки - до 8 светодиодов):
+ *    матрица - PB0..PB5(D8..D13), PC0(A0), PC1(A1); индикатор - PB0..PB3(D8..D11).
+ *  Для индикаторов с общим анодом задать DISPLAY_SEGMENTS_INVERTED=1 (build_flags): столбцы включаются низким уровнем,
+ *  строки - PNP транзисторами, которые тоже открываются низким уровнем на базе.
+ *  PD0/PD1 - это RX/TX: USART в примере не используется, при прошивке через загрузчик отсоединить матрицу.
+ *
+ * Timer2 в режиме CTC, предделитель 64: строка длится DISPLAY_ROW_TICKS = 250 тиков по 4 us = 1 ms,
+ * то есть 1000 строк в секунду (кадр 8 строк - 125 Hz, 4 разряда - 250 Hz).
+ *  - TIMER2_COMPA_vect (начало строки): гасит столбцы, переключает строку и записывает байт столбцов строки
+ *    одной записью в PORTD. Байты в буфере кадра уже готовы к записи в порт (с учетом полярности),
+ *    в прерывании нет ни шрифтов, ни сдвигов.
+ *  - TIMER2_COMPB_vect: гасит столбцы через OCR2B тиков после начала строки. Так яркость каждой строки
+ *    задается временем свечения (1..DISPLAY_ROW_TICKS), без ШИМ на каждом светодиоде.
+ *
+ * Кадр двойной буферизации: display_begin() возвращает свободный буфер, display_show() просит прерывание
+ * показать его с начала следующего кадра (строки 0). Половина кадра из старого буфера, половина из нового
+ * на экран не попадает.
+ *
+ * Стоимость при 1000 строк/с (оценка вручную по числу инструкций, с прологом и эпилогом; листингом не проверена):
+ *  TIMER2_COMPA_vect ~ 60 тактов, TIMER2_COMPB_vect ~ 20 тактов - ~80 000 тактов в секунду, 0.5% процессора.
+ *
+ * Сборка: pio run -e led-matrix (матрица 8x8) или pio run -e led-7segment (DISPLAY_SEVEN_SEGMENT, 4 разряда).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef DISPLAY_SEVEN_SEGMENT
+#define DISPLAY_ROWS 4
+#else
+#define DISPLAY_ROWS 8
+#endif
+
+#ifndef DISPLAY_SEGMENTS_INVERTED
+#define DISPLAY_SEGMENTS_INVERTED 0 // 1 - общий анод: столбцы и строки (PNP) включаются низким уровнем
+#endif
+#define DISPLAY_COLUMNS_OFF (DISPLAY_SEGMENTS_INVERTED ? 0xFF : 0x00)
+#define DISPLAY_ROW_TICKS 250 // 1 ms при предделителе 64
+
+volatile uint8_t *const DISPLAY_ROW_PORTS[8] = {&PORTB, &PORTB, &PORTB, &PORTB, &PORTB, &PORTB, &PORTC, &PORTC};
+const uint8_t DISPLAY_ROW_MASKS[8] = {
+    (1<<PB0), (1<<PB1), (1<<PB2), (1<<PB3), (1<<PB4), (1<<PB5), (1<<PC0), (1<<PC1),
+};
+
+typedef struct {
+    uint8_t columns[DISPLAY_ROWS]; // Байт для PORTD
+    uint8_t ticks[DISPLAY_ROWS]; // Время свечения строки: 0 - погашена, DISPLAY_ROW_TICKS - полная яркость
+} display_frame_t;
+
+static inline void display_row_on(uint8_t row) {
+#if DISPLAY_SEGMENTS_INVERTED
+    *DISPLAY_ROW_PORTS[row] &= ~DISPLAY_ROW_MASKS[row];
+#else
+    *DISPLAY_ROW_PORTS[row] |= DISPLAY_ROW_MASKS[row];
+#endif
+}
+
+static inline void display_row_off(uint8_t row) {
+#if DISPLAY_SEGMENTS_INVERTED
+    *DISPLAY_ROW_PORTS[row] |= DISPLAY_ROW_MASKS[row];
+#else
+    *DISPLAY_ROW_PORTS[row] &= ~DISPLAY_ROW_MASKS[row];
+#endif
+}
+
+display_frame_t display_frames[2];
+volatile uint8_t display_front; // Буфер, который показывает прерывание
+volatile bool display_pending; // display_show() вызван, прерывание переключит буфер в начале кадра
+uint8_t display_row = DISPLAY_ROWS - 1;
+volatile uint8_t display_frame_count; // Показанных кадров по модулю 256 (время для анимации)
+
+ISR(TIMER2_COMPA_vect) {
+    PORTD = DISPLAY_COLUMNS_OFF; // Сначала погасить, иначе новая строка на мгновение покажет старые столбцы
+    display_row_off(display_row);
+
+    uint8_t row = display_row + 1;
+    if (row == DISPLAY_ROWS) {
+        row = 0;
+        display_frame_count++;
+        if (display_pending) {
+            display_front ^= 1;
+            display_pending = false;
+        }
+    }
+    display_row = row;
+
+    const display_frame_t *frame = &display_frames[display_front];
+    uint8_t ticks = frame->ticks[row];
+    // OCR2B вне 0..OCR2A не совпадает никогда: полная яркость без гашения.
+    // Совпадение со старым OCR2B (короткая предыдущая строка) могло уже подняться - сбрасываем.
+    OCR2B = ticks >= DISPLAY_ROW_TICKS ? 0xFF : ticks;
+    TIFR2 = (1<<OCF2B);
+    if (ticks) {
+        display_row_on(row);
+        PORTD = frame->columns[row];
+    }
+}
+
+ISR(TIMER2_COMPB_vect) {
+    PORTD = DISPLAY_COLUMNS_OFF;
+}
+
+void display_init(void) {
+    DDRD = 0xFF;
+    PORTD = DISPLAY_COLUMNS_OFF;
+    for (uint8_t i = 0; i < DISPLAY_ROWS; i++) {
+        display_row_off(i); // До включения выхода: PNP строки открываются низким уровнем
+        *(DISPLAY_ROW_PORTS[i] - 1) |= DISPLAY_ROW_MASKS[i]; // DDRx находится перед PORTx
+    }
+
+    TCCR2A = (1<<WGM21); // CTC
+    OCR2A = DISPLAY_ROW_TICKS - 1;
+    OCR2B = 0xFF;
+    TIMSK2 = (1<<OCIE2A) | (1<<OCIE2B);
+    TCCR2B = (1<<CS22); // Предделитель 64
+}
+
+// Буфер для следующего кадра. Ждет, пока прерывание переключится на кадр из предыдущего display_show()
+// (не дольше одного кадра), иначе можно было бы рисовать в показываемый буфер.
+display_frame_t *display_begin(void) {
+    while (display_pending);
+    return &display_frames[display_front ^ 1];
+}
+
+void display_show(void) {
+    __asm__ __volatile__("" ::: "memory"); // Кадр записан до флага
+    display_pending = true;
+}
+
+#define DISPLAY_MIN_TICKS 2 // OCR2B записывается, когда TCNT2 уже может быть 1
+
+// Строка кадра: columns - биты столбцов (1 - светится), brightness - 0..255
+static inline void display_set_row(display_frame_t *frame, uint8_t row, uint8_t columns, uint8_t brightness) {
+    uint8_t ticks = ((uint16_t)brightness * DISPLAY_ROW_TICKS + 254) / 255;
+    frame->columns[row] = columns ^ DISPLAY_COLUMNS_OFF;
+    frame->ticks[row] = (ticks && ticks < DISPLAY_MIN_TICKS) ? DISPLAY_MIN_TICKS : ticks;
+}
+
+#ifdef DISPLAY_SEVEN_SEGMENT
+
+// Сегменты: бит 0 - a, ..., бит 6 - g, бит 7 - точка (dp)
+#define SEGMENT_DP (1<<7)
+
+const uint8_t SEGMENT_DIGITS[16] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, // 0..9
+    0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71, // A..F
+};
+
+// Число 0..9999. point - номер разряда справа, после которого точка (1 - "12.3", 0 - без точки).
+// Незначащие нули гасятся.
+void display_number(display_frame_t *frame, uint16_t value, uint8_t point, uint8_t brightness) {
+    for (int8_t digit = DISPLAY_ROWS - 1; digit >= 0; digit--) {
+        uint8_t position = DISPLAY_ROWS - 1 - digit; // 0 - младший разряд
+        uint8_t segments = (value || position <= point) ? SEGMENT_DIGITS[value % 10] : 0;
+        if (point && position == point) {
+            segments |= SEGMENT_DP;
+        }
+        display_set_row(frame, digit, segments, brightness);
+        value /= 10;
+    }
+}
+
+int main(void) {
+    display_init();
+    sei();
+
+    // Секундомер с десятыми: 1 кадр = 4 ms, 25 кадров = 0.1 s
+    uint16_t tenths = 0;
+    uint8_t next = 25;
+    while (1) {
+        while ((int8_t)(display_frame_count - next) < 0);
+        next += 25;
+        tenths = tenths < 9999 ? tenths + 1 : 0;
+
+        display_frame_t *frame = display_begin();
+        display_number(frame, tenths, 1, 255);
+        display_show();
+    }
+}
+
+#else
+
+int main(void) {
+    display_init();
+    sei();
+
+    // Диагональ бежит по матрице, яркость строк - от 1/8 до полной (проверка яркости по времени строки)
+    uint8_t shift = 0;
+    uint8_t next = 10;
+    while (1) {
+        while ((int8_t)(display_frame_count - next) < 0);
+        next += 10; // 10 кадров по 8 ms = 80 ms
+
+        display_frame_t *frame = display_begin();
+        for (uint8_t row = 0; row < DISPLAY_ROWS; row++) {
+            uint8_t column = (row + shift) & 7;
+            display_set_row(frame, row, (1<<column) | (1<<(7 - column)), 32 * (row + 1) - 1);
+        }
+        display_show();
+        shift++;
+    }
+}
+
+#endif
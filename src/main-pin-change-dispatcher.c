@@ -0,0 +1,200 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Диспетчер прерываний по изменению состояния пинов (Pin Change Interrupt) для всех трех портов.
+ *
+ * Прерывание PCINTx сообщает только то, что изменился какой-то пин группы, но не какой и в какую сторону.
+ * Обработчик прерывания сравнивает (XOR) текущее значение PINx с предыдущим снимком порта,
+ * получает маску изменившихся пинов и кладет в очередь событие: порт, маска изменений, новый снимок порта, время.
+ * Разбор маски на отдельные пины (pin, edge, timestamp) и вызов обработчиков выполняется в main,
+ * поэтому прерывание занимает несколько десятков тактов независимо от количества изменившихся пинов.
+ *
+ * Номера пинов совпадают с номерами PCINT:
+ * - PCINT0..7   - PB0..PB7 (PB6, PB7 на Arduino Nano заняты кварцем);
+ * - PCINT8..14  - PC0..PC6 (PC6 - RESET);
+ * - PCINT16..23 - PD0..PD7.
+ *
+ * Очередь событий - кольцевой буфер без блокировок: индекс записи меняют только прерывания (они не вложены друг в друга),
+ * индекс чтения меняет только main. Глобальные прерывания в main не запрещаются.
+ *
+ * Время события - Timer1 (предделитель 64, 1 тик = 4 us, переполнение через 262 ms), расширенный счетчиком
+ * переполнений до 24 бит (67 s). Счетчик переполнений читается в прерывании вместе с TCNT1 и хранится в событии:
+ * если main разберет очередь позже, время события не сдвинется на целые периоды по 262 ms.
+ *
+ * Программа.
+ * - Кнопка на PD2 (D2): по нажатию (спад) переключаем светодиод на PB5 (D13).
+ * - Кнопка на PC0 (A0): светодиод на PB4 (D12) горит, пока кнопка нажата.
+ * - Кнопка на PB0 (D8): измеряем длительность нажатия, светодиод на PB3 (D11) загорается при нажатии дольше 1 s.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // NULL definition
+
+#define LED_TOGGLE_PIN PB5 // PB5(D13)
+#define LED_HOLD_PIN PB4 // PB4(D12)
+#define LED_LONG_PRESS_PIN PB3 // PB3(D11)
+
+#define PCINT_PIN(port, bit) ((port) * 8 + (bit)) // port: 0 - PORTB, 1 - PORTC, 2 - PORTD
+#define PCINT_PINS_COUNT 24
+
+#define PCINT_EDGE_FALLING 1
+#define PCINT_EDGE_RISING 2
+#define PCINT_EDGE_BOTH (PCINT_EDGE_FALLING | PCINT_EDGE_RISING)
+
+typedef void (*pcint_handler_t)(uint8_t pin, uint8_t edge, uint32_t timestamp); // timestamp - 24 бита, тики 4 us
+
+typedef struct {
+    uint8_t port;
+    uint8_t changed; // Маска изменившихся пинов
+    uint8_t level; // Снимок PINx после изменения
+    uint8_t overflows; // Переполнений Timer1 на момент события (старшие 8 бит времени)
+    uint16_t timestamp; // TCNT1
+} pcint_event_t;
+
+#define PCINT_QUEUE_SIZE 16 // Степень двойки
+#define PCINT_QUEUE_MASK (PCINT_QUEUE_SIZE - 1)
+
+volatile pcint_event_t pcint_queue[PCINT_QUEUE_SIZE];
+volatile uint8_t pcint_queue_head; // Пишут только прерывания
+volatile uint8_t pcint_queue_tail; // Пишет только main
+volatile uint8_t pcint_dropped; // Сколько событий потеряно из-за переполнения очереди
+
+volatile uint8_t timer1_overflows;
+
+ISR(TIMER1_OVF_vect) {
+    timer1_overflows++;
+}
+
+uint8_t pcint_last[3]; // Предыдущие снимки PINB, PINC, PIND
+pcint_handler_t pcint_handlers[PCINT_PINS_COUNT];
+uint8_t pcint_edges[PCINT_PINS_COUNT];
+
+static inline void pcint_push(uint8_t port, uint8_t level, uint8_t mask) {
+    uint8_t changed = (level ^ pcint_last[port]) & mask;
+    pcint_last[port] = level;
+    if (changed == 0) {
+        return; // Изменение пина, не входящего в маску, или дребезг вернул прежнее значение
+    }
+
+    uint8_t head = pcint_queue_head;
+    uint8_t next = (head + 1) & PCINT_QUEUE_MASK;
+    if (next == pcint_queue_tail) {
+        pcint_dropped++;
+        return;
+    }
+    volatile pcint_event_t *event = &pcint_queue[head];
+    event->port = port;
+    event->changed = changed;
+    event->level = level;
+    uint16_t timestamp = TCNT1;
+    uint8_t overflows = timer1_overflows;
+    // PCINT приоритетнее TIMER1_OVF: переполнение могло произойти, а его обработчик еще не выполнен
+    if ((TIFR1 & (1<<TOV1)) && timestamp < 0x8000) {
+        overflows++;
+    }
+    event->timestamp = timestamp;
+    event->overflows = overflows;
+    pcint_queue_head = next; // Событие становится видимым для main только после заполнения
+}
+
+ISR(PCINT0_vect) {
+    pcint_push(0, PINB, PCMSK0);
+}
+
+ISR(PCINT1_vect) {
+    pcint_push(1, PINC, PCMSK1);
+}
+
+ISR(PCINT2_vect) {
+    pcint_push(2, PIND, PCMSK2);
+}
+
+// Регистрирует обработчик для пина и включает на нем прерывание. edges - PCINT_EDGE_FALLING, PCINT_EDGE_RISING или оба.
+void pcint_attach(uint8_t pin, pcint_handler_t handler, uint8_t edges) {
+    uint8_t port = pin / 8;
+    uint8_t bit = 1 << (pin % 8);
+
+    pcint_handlers[pin] = handler;
+    pcint_edges[pin] = edges;
+
+    // Снимок и маска меняются с запрещенным прерыванием группы, чтобы не получить ложное событие
+    PCICR &= ~(1 << port);
+    switch (port) {
+        case 0: pcint_last[0] = PINB; PCMSK0 |= bit; break;
+        case 1: pcint_last[1] = PINC; PCMSK1 |= bit; break;
+        case 2: pcint_last[2] = PIND; PCMSK2 |= bit; break;
+    }
+    PCIFR = (1 << port); // Сбрасываем флаг, выставленный до настройки
+    PCICR |= (1 << port);
+}
+
+// Разбирает события из очереди и вызывает обработчики. Вызывается из основного цикла.
+void pcint_dispatch(void) {
+    while (pcint_queue_tail != pcint_queue_head) {
+        uint8_t tail = pcint_queue_tail;
+        pcint_event_t event = pcint_queue[tail];
+        pcint_queue_tail = (tail + 1) & PCINT_QUEUE_MASK;
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (event.changed & (1 << bit)) {
+                uint8_t pin = PCINT_PIN(event.port, bit);
+                uint8_t edge = (event.level & (1 << bit)) ? PCINT_EDGE_RISING : PCINT_EDGE_FALLING;
+                if (pcint_handlers[pin] != NULL && (pcint_edges[pin] & edge)) {
+                    pcint_handlers[pin](pin, edge, ((uint32_t)event.overflows << 16) | event.timestamp);
+                }
+            }
+        }
+    }
+}
+
+void on_toggle_button(uint8_t pin, uint8_t edge, uint32_t timestamp) {
+    PORTB ^= (1<<LED_TOGGLE_PIN);
+}
+
+void on_hold_button(uint8_t pin, uint8_t edge, uint32_t timestamp) {
+    if (edge == PCINT_EDGE_FALLING) {
+        PORTB |= (1<<LED_HOLD_PIN);
+    } else {
+        PORTB &= ~(1<<LED_HOLD_PIN);
+    }
+}
+
+void on_long_press_button(uint8_t pin, uint8_t edge, uint32_t timestamp) {
+    static uint32_t press_timestamp;
+
+    if (edge == PCINT_EDGE_FALLING) {
+        press_timestamp = timestamp;
+    } else {
+        uint32_t duration = (timestamp - press_timestamp) & 0xFFFFFF; // Время - 24 бита
+        if (duration >= 250000) { // 1 s в тиках по 4 us
+            PORTB |= (1<<LED_LONG_PRESS_PIN);
+        } else {
+            PORTB &= ~(1<<LED_LONG_PRESS_PIN);
+        }
+    }
+}
+
+int main(void) {
+    DDRB |= (1<<LED_TOGGLE_PIN) | (1<<LED_HOLD_PIN) | (1<<LED_LONG_PRESS_PIN);
+
+    // Подтягиваем пины кнопок к HIGH через встроенный резистор
+    PORTD |= (1<<PD2);
+    PORTC |= (1<<PC0);
+    PORTB |= (1<<PB0);
+
+    TCCR1B = (1<<CS11) | (1<<CS10); // Timer1, prescaler = 64 (1 тик = 4 us)
+    TIMSK1 |= (1<<TOIE1);
+
+    pcint_attach(PCINT_PIN(2, PD2), &on_toggle_button, PCINT_EDGE_FALLING);
+    pcint_attach(PCINT_PIN(1, PC0), &on_hold_button, PCINT_EDGE_BOTH);
+    pcint_attach(PCINT_PIN(0, PB0), &on_long_press_button, PCINT_EDGE_BOTH);
+
+    sei();
+
+    while (1) {
+        pcint_dispatch();
+    }
+}
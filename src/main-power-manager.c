@@ -0,0 +1,97 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Автоматическое управление питанием периферии через регистр PRR (Power Reduction Register):
+ * менеджер питания include/power_manager.h. pm_acquire()/pm_release() включают и отключают тактирование модуля
+ * по счетчику ссылок, pm_sleep() засыпает в самом глубоком режиме, в котором работают все занятые модули.
+ *
+ * Программа. Микроконтроллер спит в режиме Power-down.
+ * При нажатии кнопки (соединении INT0/PD2/D2 с GND) измеряем напряжение на A5 (ADC нужен только на время измерения)
+ * и мигаем светодиодом от Timer1 столько раз, сколько четвертей шкалы набрало напряжение.
+ * Пока мигает светодиод, pm_sleep() использует режим Idle, после этого - снова Power-down.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "power_manager.h"
+
+#define LED_PIN PB5       // PB5(D13)
+#define INTERRUPT_PIN PD2 // INT0/PD2(D2)
+
+volatile bool is_interrupt_button = false;
+volatile uint8_t blink_count = 0; // Сколько переключений светодиода осталось
+
+ISR(INT0_vect) {
+    EIMSK &= ~(1<<INT0); // Прерывание по низкому уровню повторяется пока кнопка нажата, отключаем его до обработки
+    is_interrupt_button = true;
+}
+
+ISR(TIMER1_OVF_vect) {
+    PORTB ^= (1<<LED_PIN); // Включить/Выключить LED
+    blink_count--;
+}
+
+uint16_t adc_read(void) {
+    pm_acquire(PM_ADC);
+
+    ADMUX = (1<<REFS0) | (1<<MUX2) | (1<<MUX0); // Опорное напряжение AVcc, канал ADC5
+    ADCSRA = (1<<ADEN) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0); // ADC Prescaler = 128 (125 kHz)
+    ADCSRA |= (1<<ADSC); // Запуск преобразования
+    while(ADCSRA & (1<<ADSC)); // Ждем завершения преобразования (ADSC=0)
+    uint16_t value = ADC;
+
+    pm_release(PM_ADC);
+    return value;
+}
+
+void blink_start(uint8_t count) {
+    pm_acquire(PM_TIMER1);
+
+    blink_count = count * 2;
+    TCNT1 = 0;
+    TIMSK1 |= (1<<TOIE1); // Включаем прерывание по переполнению
+    TCCR1B = (1<<CS11) | (1<<CS10); // Задаем prescaler = 64 (прерывание через каждые ~262 ms)
+}
+
+void blink_stop(void) {
+    TCCR1B = 0; // Останавливаем таймер
+    TIMSK1 &= ~(1<<TOIE1);
+    PORTB &= ~(1<<LED_PIN);
+
+    pm_release(PM_TIMER1);
+}
+
+int main(void) {
+    pm_init();
+
+    DDRB |= (1<<LED_PIN); // Настройка PB5 на выход
+
+    PORTD |= (1<<INTERRUPT_PIN); // Подтягиваем PD2 к high
+    // Прерывание на INT0/PD2 будет сгенерировано при низком уровне (low), ISC01=0, ISC00=0
+    // Только прерывание по уровню выводит микроконтроллер из режима Power-down
+    EIMSK |= (1<<INT0);
+
+    bool is_blinking = false;
+
+    while (1) {
+        pm_sleep();
+
+        if (is_interrupt_button && !is_blinking) {
+            is_interrupt_button = false;
+            uint16_t value = adc_read();
+            blink_start(1 + value / 256);
+            is_blinking = true;
+        }
+
+        if (is_blinking && blink_count == 0) {
+            blink_stop();
+            is_blinking = false;
+            EIFR = (1<<INTF0);
+            EIMSK |= (1<<INT0); // Снова ждем нажатия кнопки
+        }
+    }
+}
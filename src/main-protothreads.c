@@ -0,0 +1,108 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Протопотоки (include/pt.h) вместо блокирующих _delay_ms(): поведение main-blink.c, main-sleep.c,
+ * main-wdt-sleep.c и main-adc.c выполняется одновременно, а в паузах микроконтроллер спит.
+ *
+ * Потоки:
+ *  - heartbeat - мигает светодиодом D13 (PB5) с интервалом в 1 секунду (main-blink.c);
+ *  - startup   - при запуске быстро мигает светодиодом D4 (PD4) три раза и завершается (main-wdt-sleep.c);
+ *  - button    - по нажатию кнопки (соединении INT0/PD2/D2 с GND) мигает светодиодом D5 (PD5) три раза (main-sleep.c);
+ *  - light     - каждые 100 мс измеряет напряжение на фоторезисторе (A5) и включает светодиоды D9..D11 (main-adc.c).
+ *
+ * Состояние каждого потока - 4 байта (pt_t), все потоки вместе занимают 16 байт SRAM.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+
+#include "pt.h"
+
+#define LED_HEARTBEAT_PIN PB5 // PB5(D13)
+#define LED_STARTUP_PIN PD4 // PD4(D4)
+#define LED_BUTTON_PIN PD5 // PD5(D5)
+#define LED_RED_PIN PB3 // PB3(D11)
+#define LED_YELLOW_PIN PB2 // PB2(D10)
+#define LED_GREEN_PIN PB1 // PB1(D9)
+#define BUTTON_PIN PD2 // INT0/PD2(D2)
+#define LIGHT_ADC_CHANNEL 5 // ADC5/PC5(A5)
+
+#define EVENT_BUTTON (1<<0)
+
+ISR(INT0_vect) {
+    pt_signal(EVENT_BUTTON);
+}
+
+PT_THREAD(heartbeat(pt_t *pt)) {
+    PT_BEGIN(pt);
+    while (1) {
+        PORTB ^= (1<<LED_HEARTBEAT_PIN);
+        PT_AWAIT_MS(pt, 1000);
+    }
+    PT_END(pt);
+}
+
+PT_THREAD(startup(pt_t *pt)) {
+    static uint8_t i; // Локальные переменные не сохраняются между ожиданиями
+
+    PT_BEGIN(pt);
+    for (i = 0; i < 3; i++) {
+        PORTD |= (1<<LED_STARTUP_PIN);
+        PT_AWAIT_MS(pt, 100);
+        PORTD &= ~(1<<LED_STARTUP_PIN);
+        PT_AWAIT_MS(pt, 100);
+    }
+    PT_END(pt);
+}
+
+PT_THREAD(button(pt_t *pt)) {
+    static uint8_t i;
+
+    PT_BEGIN(pt);
+    while (1) {
+        PT_AWAIT_EVENT(pt, EVENT_BUTTON);
+        for (i = 0; i < 3; i++) {
+            PORTD |= (1<<LED_BUTTON_PIN);
+            PT_AWAIT_MS(pt, 1000);
+            PORTD &= ~(1<<LED_BUTTON_PIN);
+            PT_AWAIT_MS(pt, 1000);
+        }
+        pt_take_event(EVENT_BUTTON); // Нажатия во время мигания (и дребезг контактов) игнорируем
+    }
+    PT_END(pt);
+}
+
+PT_THREAD(light(pt_t *pt)) {
+    static uint16_t value;
+
+    PT_BEGIN(pt);
+    while (1) {
+        PT_AWAIT_ADC(pt, LIGHT_ADC_CHANNEL, &value);
+        uint8_t leds = 0;
+        if (value >= 256) leds |= (1<<LED_RED_PIN);
+        if (value >= 512) leds |= (1<<LED_YELLOW_PIN);
+        if (value >= 768) leds |= (1<<LED_GREEN_PIN);
+        PORTB = (PORTB & ~((1<<LED_RED_PIN) | (1<<LED_YELLOW_PIN) | (1<<LED_GREEN_PIN))) | leds;
+        PT_AWAIT_MS(pt, 100);
+    }
+    PT_END(pt);
+}
+
+static pt_t threads[4];
+static const pt_func_t THREADS[4] = {heartbeat, startup, button, light};
+
+int main(void) {
+    DDRB |= (1<<LED_HEARTBEAT_PIN) | (1<<LED_RED_PIN) | (1<<LED_YELLOW_PIN) | (1<<LED_GREEN_PIN);
+    DDRD |= (1<<LED_STARTUP_PIN) | (1<<LED_BUTTON_PIN);
+
+    PORTD |= (1<<BUTTON_PIN); // Подтягиваем PD2 к high
+    EICRA |= (1<<ISC01); // Прерывание INT0 по спаду (нажатие)
+    EIMSK |= (1<<INT0);
+
+    pt_init();
+    pt_run(threads, THREADS, sizeof(THREADS) / sizeof(THREADS[0])); // Потоки heartbeat, button и light не завершаются
+
+    while (1) {
+    }
+}
@@ -0,0 +1,203 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Чтение инкрементальных (квадратурных) энкодеров на прерываниях по изменению состояния пинов (Pin Change Interrupt).
+ *
+ * Энкодер выдает два сигнала A и B, сдвинутых на четверть периода (код Грея):
+ *  по часовой стрелке:    00 -> 01 -> 11 -> 10 -> 00
+ *  против часовой:        00 -> 10 -> 11 -> 01 -> 00
+ * Каждое изменение A или B - это один шаг (4 шага на период).
+ *
+ * Направление определяется по таблице из 16 элементов, индекс - предыдущее и текущее состояние AB (4 бита).
+ * Одновременное изменение A и B (00 <-> 11, 01 <-> 10) невозможно для исправного энкодера:
+ * это значит, что фронт был пропущен (слишком высокая частота или помеха). Такие переходы считаются в encoder_errors.
+ *
+ * Несколько энкодеров подключены к одному порту (PORTC), одно прерывание PCINT1 обрабатывает все энкодеры.
+ * Обработчик не содержит циклов и ветвлений по числу энкодеров (развернут макросом), таблица лежит в SRAM
+ * (ld - 2 такта, lpm из PROGMEM - 3 такта).
+ *
+ * Оценка стоимости: ~35 тактов на вход/выход из прерывания + ~20 тактов на энкодер,
+ * для трех энкодеров ~95 тактов (~6 us при 16 MHz). Фронт пропускается, если следующий фронт того же энкодера
+ * приходит раньше, чем прерывание прочитает PINC. Максимальную частоту фронтов измеряет бенчмарк (см. ниже).
+ *
+ * Подключение (общий вывод энкодеров - на GND, A/B подтянуты встроенными резисторами):
+ * - энкодер 0: A - PC0 (A0), B - PC1 (A1);
+ * - энкодер 1: A - PC2 (A2), B - PC3 (A3);
+ * - энкодер 2: A - PC4 (A4), B - PC5 (A5).
+ *
+ * Программа. Светодиод на PB5 (D13) переключается через каждые 4 шага (1 период) энкодера 0,
+ * светодиод на PB4 (D12) загорается при обнаружении недопустимого перехода на любом энкодере.
+ *
+ * Бенчмарк (окружение rotary-encoder-benchmark, флаг ENCODER_BENCHMARK).
+ * Timer2 в режиме CTC переключает выходы OC2A (PB3/D11) и OC2B (PD3/D3) с разными регистрами совпадения -
+ * получаются два меандра, сдвинутые на четверть периода, то есть эталонный квадратурный сигнал.
+ * Соединить перемычками: PD3 (D3) -> PC0 (A0), PB3 (D11) -> PC1 (A1).
+ * OC2B переключается первым, поэтому энкодер 0 считает вперед (+1 на каждый фронт).
+ * Генератор останавливает INT1_vect (OC2B - пин INT1), а ожидаемое число шагов считается по фактическим
+ * переключениям OC2A и OC2B, поэтому ошибка измерения - всегда ошибка энкодера, а не лишний фронт генератора.
+ * Частота фронтов F = 2 * 16 MHz / (8 * (OCR2A + 1)). Бенчмарк уменьшает OCR2A, пока энкодер 0 считает без ошибок
+ * (число шагов совпадает с числом фронтов генератора, нет недопустимых переходов). Результат (последняя частота без ошибок)
+ * сохраняется в benchmark_max_edge_rate_hz, светодиод на PB5 мигает, когда измерение закончено.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LED_STEP_PIN PB5 // PB5(D13)
+#define LED_ERROR_PIN PB4 // PB4(D12)
+
+#define ENCODERS_COUNT 3
+#define ENCODERS_MASK 0b00111111 // PC0..PC5
+
+#define ENCODER_ILLEGAL 2 // Признак недопустимого перехода в таблице
+
+// Индекс: (предыдущее AB << 2) | текущее AB, где A - младший бит
+int8_t encoder_table[16] = {
+    // текущее:  00  01  10  11
+    /* 00 */      0, +1, -1, ENCODER_ILLEGAL,
+    /* 01 */     -1,  0, ENCODER_ILLEGAL, +1,
+    /* 10 */     +1, ENCODER_ILLEGAL,  0, -1,
+    /* 11 */     ENCODER_ILLEGAL, -1, +1,  0,
+};
+
+volatile int16_t encoder_position[ENCODERS_COUNT];
+volatile uint8_t encoder_errors[ENCODERS_COUNT];
+uint8_t encoder_state; // Предыдущее состояние PINC (только для прерывания)
+
+// Обработка одного энкодера, пины A/B - биты (2 * n) и (2 * n + 1) порта
+#define ENCODER_UPDATE(n, prev, curr) do { \
+    int8_t delta = encoder_table[(((prev) >> (2 * (n))) & 0b11) << 2 | (((curr) >> (2 * (n))) & 0b11)]; \
+    if (delta == ENCODER_ILLEGAL) { \
+        encoder_errors[n]++; \
+    } else { \
+        encoder_position[n] += delta; \
+    } \
+} while (0)
+
+ISR(PCINT1_vect) {
+    uint8_t curr = PINC;
+    uint8_t prev = encoder_state;
+    encoder_state = curr;
+
+    ENCODER_UPDATE(0, prev, curr);
+    ENCODER_UPDATE(1, prev, curr);
+    ENCODER_UPDATE(2, prev, curr);
+}
+
+int16_t encoder_read(uint8_t n) {
+    int16_t value;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        value = encoder_position[n];
+    }
+    return value;
+}
+
+void encoder_init(void) {
+    // Пины энкодеров на вход (по умолчанию), подтягиваем к HIGH через встроенный резистор
+    PORTC |= ENCODERS_MASK;
+    encoder_state = PINC;
+
+    PCMSK1 |= ENCODERS_MASK; // Разрешить прерывания на пинах энкодеров
+    PCIFR = (1<<PCIF1);
+    PCICR |= (1<<PCIE1); // Разрешить прерывания на группе контактов PCIE1 (PORTC)
+}
+
+#ifdef ENCODER_BENCHMARK
+
+#define BENCHMARK_PRESCALER 8
+#define BENCHMARK_EDGES 4000 // Фронтов генератора на одно измерение
+
+volatile uint16_t benchmark_toggles; // Переключения OC2B (считаются в INT1_vect)
+volatile uint32_t benchmark_max_edge_rate_hz;
+
+// OC2B - это пин INT1 (PD3): прерывание по любому изменению срабатывает и на выходе. INT1 приоритетнее PCINT1,
+// поэтому генератор останавливается сразу после нужного переключения, даже когда энкодер не успевает.
+// Обработчик короче обработчика энкодера, и счет переключений точен на частотах выше предела энкодера.
+ISR(INT1_vect) {
+    if (++benchmark_toggles >= BENCHMARK_EDGES / 2) {
+        TCCR2B = 0; // Останавливаем генератор
+    }
+}
+
+// Генерирует BENCHMARK_EDGES фронтов с заданным OCR2A и проверяет, что энкодер 0 их все посчитал.
+bool benchmark_run(uint8_t top) {
+    // Генератор в состоянии 00: выходы OC2A/OC2B хранят уровень и после TCCR2A = 0, поэтому сбрасываем их
+    // принудительным совпадением (FOC2A/FOC2B) в режиме "сброс при совпадении"
+    TCCR2B = 0;
+    TCCR2A = (1<<COM2A1) | (1<<COM2B1) | (1<<WGM21);
+    TCCR2B = (1<<FOC2A) | (1<<FOC2B);
+    while (PINC & 0b11);
+    EIMSK &= ~(1<<INT1);
+    encoder_position[0] = 0; // Прерывания энкодера в этот момент не приходят
+    encoder_errors[0] = 0;
+    benchmark_toggles = 0;
+
+    TCNT2 = 0;
+    OCR2A = top;
+    OCR2B = top / 2;
+    EICRA = (EICRA & ~((1<<ISC11) | (1<<ISC10))) | (1<<ISC10); // INT1 по любому изменению
+    EIFR = (1<<INTF1);
+    EIMSK |= (1<<INT1);
+    TCCR2A = (1<<COM2A0) | (1<<COM2B0) | (1<<WGM21); // CTC, переключение OC2A и OC2B при совпадении
+    TCCR2B = (1<<CS21); // prescaler = 8, запуск
+
+    while (TCCR2B != 0);
+    EIMSK &= ~(1<<INT1);
+    _delay_us(20); // Последний фронт еще может ждать обработчика энкодера
+
+    // Фронтов было столько, сколько переключений OC2B и OC2A. OC2A переключается после OC2B в том же периоде
+    // и мог успеть или не успеть до остановки: равные уровни - успел.
+    bool a = PINB & (1<<PB3);
+    bool b = PIND & (1<<PD3);
+    int16_t edges = 2 * benchmark_toggles - (a != b ? 1 : 0);
+
+    return encoder_read(0) == edges && encoder_errors[0] == 0;
+}
+
+int main(void) {
+    DDRB |= (1<<LED_STEP_PIN) | (1<<LED_ERROR_PIN) | (1<<PB3);
+    DDRD |= (1<<PD3);
+
+    encoder_init();
+    sei();
+
+    for (uint16_t top = 255; top >= 1; top--) {
+        if (!benchmark_run(top)) {
+            PORTB |= (1<<LED_ERROR_PIN);
+            break;
+        }
+        benchmark_max_edge_rate_hz = 2 * F_CPU / (BENCHMARK_PRESCALER * (top + 1UL));
+    }
+
+    while (1) {
+        PORTB ^= (1<<LED_STEP_PIN);
+        for (volatile uint32_t i = 0; i < 200000; i++);
+    }
+}
+
+#else
+
+int main(void) {
+    DDRB |= (1<<LED_STEP_PIN) | (1<<LED_ERROR_PIN);
+
+    encoder_init();
+    sei();
+
+    while (1) {
+        if (encoder_read(0) & 0b100) { // Бит 2 меняется через каждые 4 шага
+            PORTB |= (1<<LED_STEP_PIN);
+        } else {
+            PORTB &= ~(1<<LED_STEP_PIN);
+        }
+
+        if (encoder_errors[0] || encoder_errors[1] || encoder_errors[2]) {
+            PORTB |= (1<<LED_ERROR_PIN);
+        }
+    }
+}
+
+#endif
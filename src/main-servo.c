@@ -0,0 +1,135 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Восемь сервоприводов (RC servo) от одного канала сравнения Timer1.
+ *
+ * Аппаратный ШИМ Timer1 (main-pwm-fast.c) дает только два 16-битных канала (OC1A, OC1B). Сервоприводу же нужен
+ * импульс 0.5-2.5 ms раз в 20 ms, то есть канал почти все время свободен. Поэтому импульсы сервоприводов
+ * идут по очереди: прерывание TIMER1_COMPA_vect снимает импульс текущего сервопривода, подает импульс
+ * следующего и записывает в OCR1A время его окончания. После последнего сервопривода - пауза до конца кадра 20 ms.
+ *
+ * Timer1 считает без остановки (режим Normal, предделитель 8): 1 тик = 0.5 us - это и есть разрешение.
+ * Время следующего события - OCR1A += длительность, поэтому задержка входа в прерывание не накапливается.
+ * Пины сервоприводов - любые (таблица SERVO_PORTS/SERVO_MASKS), здесь D2..D7 и D8, D9.
+ *
+ * Позиции буферизуются: servo_update() копирует новые длительности в буфер, а прерывание в начале паузы
+ * (после импульса последнего сервопривода) переносит их в рабочий массив. Все сервоприводы одного кадра
+ * получают значения из одного вызова servo_update(), cli() не нужен.
+ *
+ * Восемь импульсов по SERVO_MAX_US = 2400 us занимают 19.2 ms, кадр остается 20 ms (50 Hz). Если сервоприводов
+ * больше (SERVO_COUNT > 8), кадр удлиняется до суммы импульсов + SERVO_GAP_MIN_US, большинство сервоприводов
+ * это допускает. Можно также подключить вторую группу к OCR1B, но тогда совпадения A и B иногда приходят
+ * одновременно, и одно из прерываний ждет другое (дрожание ~3 us).
+ *
+ * Дрожание (jitter) фронтов измеряется в симуляторе: tools/simbench/simbench.py -e servo
+ * (ширина импульса каждого пина: min/max в тактах; D2 в дрожание не входит - сервопривод 0 движется).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SERVO_COUNT 8
+#define SERVO_MIN_US 544
+#define SERVO_MAX_US 2400
+#define SERVO_FRAME_US 20000
+#define SERVO_GAP_MIN_US 500
+
+#define US_TO_TICKS(us) ((us) * 2) // Предделитель 8: 0.5 us на тик
+
+volatile uint8_t *const SERVO_PORTS[SERVO_COUNT] = {&PORTD, &PORTD, &PORTD, &PORTD, &PORTD, &PORTD, &PORTB, &PORTB};
+const uint8_t SERVO_MASKS[SERVO_COUNT] = {
+    (1<<PD2), (1<<PD3), (1<<PD4), (1<<PD5), (1<<PD6), (1<<PD7), (1<<PB0), (1<<PB1),
+};
+
+uint16_t servo_ticks[SERVO_COUNT]; // Рабочие длительности (читает только прерывание)
+uint16_t servo_gap_ticks;
+uint8_t servo_slot = SERVO_COUNT; // Текущий импульс, SERVO_COUNT - пауза
+
+uint16_t servo_pending[SERVO_COUNT]; // Новые длительности (пишет main, пока servo_pending_ready = false)
+uint16_t servo_pending_gap;
+volatile bool servo_pending_ready;
+
+ISR(TIMER1_COMPA_vect) {
+    uint8_t slot = servo_slot;
+    if (slot < SERVO_COUNT) {
+        *SERVO_PORTS[slot] &= ~SERVO_MASKS[slot]; // Конец импульса
+        slot++;
+    } else {
+        slot = 0; // Конец паузы - начало кадра
+    }
+
+    if (slot < SERVO_COUNT) {
+        *SERVO_PORTS[slot] |= SERVO_MASKS[slot];
+        OCR1A += servo_ticks[slot];
+    } else {
+        OCR1A += servo_gap_ticks;
+        // Начало паузы: импульсов нет до следующего кадра, можно взять новые позиции
+        if (servo_pending_ready) {
+            for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+                servo_ticks[i] = servo_pending[i];
+            }
+            servo_gap_ticks = servo_pending_gap;
+            servo_pending_ready = false;
+        }
+    }
+    servo_slot = slot;
+}
+
+// Задает позиции всех сервоприводов (us). false - предыдущие позиции еще не взяты (не позже чем через кадр).
+bool servo_update(const uint16_t *positions_us) {
+    if (servo_pending_ready) {
+        return false;
+    }
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+        uint16_t us = positions_us[i];
+        us = us < SERVO_MIN_US ? SERVO_MIN_US : us > SERVO_MAX_US ? SERVO_MAX_US : us;
+        servo_pending[i] = US_TO_TICKS(us);
+        total += us;
+    }
+    uint32_t gap = total + SERVO_GAP_MIN_US > SERVO_FRAME_US ? SERVO_GAP_MIN_US : SERVO_FRAME_US - total;
+    servo_pending_gap = US_TO_TICKS(gap);
+    __asm__ __volatile__("" ::: "memory"); // Буфер записан до флага
+    servo_pending_ready = true;
+    return true;
+}
+
+void servo_init(const uint16_t *positions_us) {
+    for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+        *(SERVO_PORTS[i] - 1) |= SERVO_MASKS[i]; // DDRx находится перед PORTx
+    }
+    servo_update(positions_us);
+    for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+        servo_ticks[i] = servo_pending[i];
+    }
+    servo_gap_ticks = servo_pending_gap;
+    servo_pending_ready = false;
+
+    TCCR1A = 0; // Normal
+    OCR1A = TCNT1 + US_TO_TICKS(SERVO_GAP_MIN_US); // Первый кадр начнется после короткой паузы
+    TIFR1 = (1<<OCF1A);
+    TIMSK1 |= (1<<OCIE1A);
+    TCCR1B = (1<<CS11); // Предделитель 8
+}
+
+int main(void) {
+    uint16_t positions[SERVO_COUNT];
+    for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+        positions[i] = 1000 + i * 125; // Разные постоянные позиции: 1000..1875 us
+    }
+    servo_init(positions);
+    sei();
+
+    // Сервопривод 0 плавно ходит от края до края, остальные стоят (их импульсы - для измерения дрожания)
+    int16_t step = 10;
+    while (1) {
+        if (servo_update(positions)) {
+            positions[0] += step;
+            if (positions[0] >= SERVO_MAX_US || positions[0] <= SERVO_MIN_US) {
+                step = -step;
+            }
+        }
+    }
+}
@@ -0,0 +1,257 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Расширение выходов цепочкой сдвиговых регистров 74HC595: кадр уходит по SPI из прерывания SPI_STC_vect
+ * и защелкивается на всех выходах одновременно. 16 светофоров (48 ламп) из main-traffic-light.c
+ * на 4 пинах вместо 48.
+ *
+ * Подключение (6 регистров, Q7' каждого - на SER следующего):
+ *  - PB3(D11, MOSI) - SER (вход данных) первого 74HC595;
+ *  - PB5(D13, SCK) - SRCLK (сдвиг) всех регистров;
+ *  - PB2(D10, SS) - RCLK (защелка) всех регистров. SS в режиме ведущего должен быть выходом - он и защелкивает;
+ *  - PB1(D9) - OE всех регистров, подтяжка 10K к 5 V: после включения в регистрах случайные данные,
+ *    выходы включаются только после первого кадра;
+ *  - SRCLR - 5 V. Провода SRCLK короткие: при fosc/2 фронты идут с частотой 8 MHz (74HC595 - до 25 MHz при 4.5 V).
+ *
+ * Выход n - бит n % 8 байта n / 8 кадра, байт 0 - первый регистр цепочки (ближний к МК), бит 0 - QA.
+ * Байты отправляются с последнего: первый отправленный байт проходит через всю цепочку.
+ *
+ * Двойная буферизация, как в main-led-matrix.c: shift_begin() возвращает свободный буфер, shift_show() просит
+ * прерывание отправить его. Кадр отправляется целиком, фронт RCLK после последнего байта переносит его
+ * на выходы всех регистров сразу - на выходах не бывает половины старого и половины нового кадра.
+ * Регистры хранят состояние сами, поэтому кадр отправляется только при изменении (после shift_show()).
+ * SPI захватывается у менеджера питания (power_manager.h) только на время передачи: между кадрами
+ * его тактирование отключено.
+ *
+ * Скорость SPI - fosc/2 (SPI2X): байт передается за 16 тактов, быстрее входа и выхода из обработчика
+ * (оценка вручную по числу инструкций, листингом не проверена: ~45 тактов на байт с прологом и эпилогом).
+ * Поэтому на fosc/2 скорость ограничивает обработчик, а не SPI: передача идет с паузами между байтами,
+ * и пока кадр отправляется, основной цикл получает по одной инструкции между прерываниями. Кадр из 6 байт
+ * - по той же оценке ~300 тактов (~19 us), т.е. несколько десятков тысяч кадров в секунду - для ламп это время
+ * незаметно; измеренное значение печатает бенчмарк при запуске (см. ниже). Опрос SPIF в цикле дал бы
+ * ~18 тактов на байт, но занимал бы процессор так же полностью.
+ *
+ * При запуске программа измеряет частоту обновления: BENCHMARK_FRAMES кадров подряд по Timer1
+ * (предделитель 64, 4 us) и печатает в USART (1 000 000 бод) кадров в секунду (frames_per_s)
+ * и тактов на кадр и на байт (cycles_per_frame, cycles_per_byte).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "power_manager.h"
+#include "usart_polled.h"
+
+#define SHIFT_BYTES 6 // Регистров 74HC595 в цепочке
+
+#define SHIFT_MOSI_PIN PB3 // PB3(D11)
+#define SHIFT_SCK_PIN PB5 // PB5(D13)
+#define SHIFT_LATCH_PIN PB2 // PB2(D10), RCLK
+#define SHIFT_OE_PIN PB1 // PB1(D9), OE (активный уровень - низкий)
+
+// --- Выходы на 74HC595 ---
+
+typedef uint8_t shift_image_t[SHIFT_BYTES];
+
+shift_image_t shift_images[2];
+volatile uint8_t shift_front; // Буфер, который отправляет прерывание
+volatile bool shift_pending; // shift_show() вызван, прерывание отправит буфер после текущего кадра
+volatile bool shift_busy; // Кадр передается
+uint8_t shift_position; // Следующий байт кадра (отправляются с последнего)
+volatile uint16_t shift_frame_count; // Защелкнутых кадров
+
+// Переключает буфер и отправляет первый байт. Прерывания запрещены.
+static inline void shift_start_frame(void) {
+    shift_front ^= 1;
+    shift_pending = false;
+    shift_position = SHIFT_BYTES - 1;
+    SPDR = shift_images[shift_front][SHIFT_BYTES - 1];
+}
+
+ISR(SPI_STC_vect) {
+    if (shift_position) {
+        SPDR = shift_images[shift_front][--shift_position];
+        return;
+    }
+    // Последний байт передан: фронт RCLK переносит кадр на выходы всех регистров
+    PORTB |= (1<<SHIFT_LATCH_PIN);
+    PORTB &= ~(1<<SHIFT_LATCH_PIN);
+    PORTB &= ~(1<<SHIFT_OE_PIN); // Выходы включены (после первого кадра)
+    shift_frame_count++;
+    if (shift_pending) {
+        shift_start_frame();
+    } else {
+        shift_busy = false;
+        pm_release(PM_SPI); // Между кадрами SPI не тактируется
+    }
+}
+
+void shift_init(void) {
+    PORTB |= (1<<SHIFT_OE_PIN); // Выходы выключены до первого кадра
+    DDRB |= (1<<SHIFT_MOSI_PIN) | (1<<SHIFT_SCK_PIN) | (1<<SHIFT_LATCH_PIN) | (1<<SHIFT_OE_PIN);
+}
+
+// Включает SPI перед кадром. После отключения тактирования (PRSPI) SPI нужно настроить заново.
+static inline void shift_spi_enable(void) {
+    pm_acquire(PM_SPI);
+    SPCR = (1<<SPIE) | (1<<SPE) | (1<<MSTR); // Ведущий, режим 0, старший бит первым
+    SPSR = (1<<SPI2X); // fosc/2 = 8 MHz
+}
+
+// Буфер для следующего кадра. Ждет, пока прерывание возьмет кадр из предыдущего shift_show()
+// (не дольше одного кадра), иначе можно было бы писать в отправляемый буфер.
+uint8_t *shift_begin(void) {
+    while (shift_pending);
+    return shift_images[shift_front ^ 1];
+}
+
+void shift_show(void) {
+    __asm__ __volatile__("" ::: "memory"); // Кадр записан до флага
+    uint8_t sreg = SREG;
+    cli();
+    shift_pending = true;
+    if (!shift_busy) {
+        shift_busy = true;
+        shift_spi_enable();
+        shift_start_frame();
+    }
+    SREG = sreg;
+}
+
+static inline void shift_set_output(uint8_t *image, uint8_t output, bool value) {
+    if (value) {
+        image[output >> 3] |= (1 << (output & 7));
+    } else {
+        image[output >> 3] &= ~(1 << (output & 7));
+    }
+}
+
+// --- Измерение частоты обновления ---
+
+#define BENCHMARK_FRAMES 1000
+
+void benchmark(void) {
+    pm_acquire(PM_TIMER1);
+    TCCR1A = 0;
+    TCCR1B = (1<<CS11) | (1<<CS10); // Предделитель 64: 4 us на тик, до 262 ms
+    uint16_t start = TCNT1;
+    for (uint16_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        uint8_t *image = shift_begin();
+        for (uint8_t j = 0; j < SHIFT_BYTES; j++) {
+            image[j] = (i & 1) ? 0x55 : 0xAA;
+        }
+        shift_show();
+    }
+    while (shift_busy);
+    uint16_t ticks = TCNT1 - start;
+    TCCR1B = 0;
+    pm_release(PM_TIMER1);
+
+    uint32_t cycles = (uint32_t)ticks * 64;
+    usart_print_blocking("bytes=");
+    usart_print_uint_blocking(SHIFT_BYTES);
+    usart_print_blocking(" frames_per_s=");
+    usart_print_uint_blocking((uint32_t)BENCHMARK_FRAMES * 250000UL / ticks);
+    usart_print_blocking(" cycles_per_frame=");
+    usart_print_uint_blocking(cycles / BENCHMARK_FRAMES);
+    usart_print_blocking(" cycles_per_byte=");
+    usart_print_uint_blocking(cycles / ((uint32_t)BENCHMARK_FRAMES * SHIFT_BYTES));
+    usart_print_blocking("\r\n");
+}
+
+// --- Светофоры (как в main-traffic-light.c, но лампы - выходы 74HC595) ---
+
+#define LIGHTS 16 // Лампы светофора i - выходы 3 * i (зеленый), 3 * i + 1 (желтый), 3 * i + 2 (красный)
+
+#define GREEN_BIT 0
+#define YELLOW_BIT 1
+#define RED_BIT 2
+
+#define LONG_DELAY 2000
+#define SHORT_DELAY 400
+#define LIGHT_OFFSET 250 // Светофоры начинают со сдвигом, чтобы переключались в разное время
+
+typedef struct {
+    const uint8_t state;
+    const uint16_t delay;
+} step_t;
+
+const step_t STEPS[] = {
+    {.state = (1<<GREEN_BIT), .delay = LONG_DELAY},
+    {.state = 0, .delay = SHORT_DELAY},
+    {.state = (1<<GREEN_BIT), .delay = SHORT_DELAY},
+    {.state = 0, .delay = SHORT_DELAY},
+    {.state = (1<<GREEN_BIT), .delay = SHORT_DELAY},
+    {.state = 0, .delay = SHORT_DELAY},
+    {.state = (1<<GREEN_BIT), .delay = SHORT_DELAY},
+    {.state = (1<<YELLOW_BIT), .delay = LONG_DELAY},
+    {.state = (1<<RED_BIT), .delay = LONG_DELAY},
+};
+
+#define STEPS_SIZE (sizeof(STEPS) / sizeof(STEPS[0]))
+
+volatile uint16_t timer_counter_ms;
+
+ISR(TIMER0_COMPA_vect) {
+    timer_counter_ms++;
+}
+
+uint16_t millis(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t value = timer_counter_ms;
+    SREG = sreg;
+    return value;
+}
+
+int main(void) {
+    pm_init();
+    pm_acquire(PM_USART0);
+    usart_init(false);
+    shift_init();
+    sei();
+
+    benchmark();
+
+    pm_acquire(PM_TIMER0);
+    // Timer0: CTC, предделитель 64, 250 тиков по 4 us = 1 ms
+    TCCR0A = (1<<WGM01);
+    OCR0A = 249;
+    TIMSK0 = (1<<OCIE0A);
+    TCCR0B = (1<<CS01) | (1<<CS00);
+
+    uint8_t step_index[LIGHTS];
+    uint16_t step_start[LIGHTS];
+    uint16_t now = millis();
+    for (uint8_t i = 0; i < LIGHTS; i++) {
+        step_index[i] = STEPS_SIZE - 1; // Первая проверка переключит на шаг 0
+        step_start[i] = now - STEPS[STEPS_SIZE - 1].delay + i * LIGHT_OFFSET;
+    }
+
+    while (1) {
+        now = millis();
+        bool changed = false;
+        for (uint8_t i = 0; i < LIGHTS; i++) {
+            // Разность по модулю 2^16: работает и после переполнения счетчика (сдвиг старта - "в будущем")
+            int16_t elapsed = now - step_start[i];
+            if (elapsed >= (int16_t)STEPS[step_index[i]].delay) {
+                step_start[i] += STEPS[step_index[i]].delay;
+                step_index[i] = step_index[i] < STEPS_SIZE - 1 ? step_index[i] + 1 : 0;
+                changed = true;
+            }
+        }
+        if (changed) {
+            // Кадр собирается заново целиком: свободный буфер содержит кадр до предыдущего
+            uint8_t *image = shift_begin();
+            for (uint8_t i = 0; i < LIGHTS; i++) {
+                uint8_t state = STEPS[step_index[i]].state;
+                shift_set_output(image, 3 * i + GREEN_BIT, state & (1<<GREEN_BIT));
+                shift_set_output(image, 3 * i + YELLOW_BIT, state & (1<<YELLOW_BIT));
+                shift_set_output(image, 3 * i + RED_BIT, state & (1<<RED_BIT));
+            }
+            shift_show();
+        }
+    }
+}
@@ -43,6 +43,8 @@ int main(void) {
         // Микроконтроллер выйдет из режима Power-down Mode, когда произойдет событие, которое сгенерирует прерывание RTC.
         // Например, это может быть срабатывание таймера RTC, приход внешнего сигнала на вход INT0 или INT1,
         // изменение состояния шины SPI или I2C и т. д.
+        // Генератор после Power-down запускается заново (~1 ms), и обработчик прерывания начнется с этой задержкой.
+        // Если она важна, режим выбирается по допустимой задержке (include/sleep_latency.h, main-wake-latency.c).
         set_sleep_mode(SLEEP_MODE_PWR_DOWN);
         sleep_mode();
         // Функция sleep_mode() аналогична вызову нескольких функций:
@@ -0,0 +1,287 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Генератор импульсов STEP/DIR для драйвера шагового двигателя (A4988, DRV8825, TMC2208 ...) с разгоном и торможением.
+ *
+ * STEP - OC1A/PB1(D9), DIR - PB0(D8).
+ * Импульсы формирует аппаратура Timer1: режим CTC (TOP = OCR1A), выход OC1A переключается при каждом совпадении.
+ * Шаг - это полупериод низкого уровня, фронт (шаг драйвера) и полупериод высокого уровня. Момент фронта задает
+ * таймер, а не программа, поэтому задержка входа в прерывание не влияет на равномерность шагов.
+ * Прерывание TIMER1_COMPA_vect только записывает в OCR1A длительность следующего полупериода.
+ *
+ * Профиль скорости - трапеция: разгон с ускорением RAMP_ACCEL шагов/с², движение на MAX_SPEED шагов/с, торможение.
+ * Если перемещение короткое, трапеция становится треугольником (разгон до середины, затем торможение).
+ *
+ * Таблица разгона считается заранее в main только целыми числами по алгоритму D. Austin
+ * ("Generate stepper-motor speed profiles in real time", 2005): период первого шага c0 = 0.676 * F * sqrt(2 / a),
+ * следующие - c[n] = c[n-1] - 2 * c[n-1] / (4n + 1) (с 8 битами дробной части).
+ * Таблица из двух частей:
+ *  - в начале разгона период заметно меняется каждый шаг - хранится период каждого шага (ramp_fast, 2 байта на шаг);
+ *  - дальше период уменьшается меньше, чем на тик таймера за шаг, то есть проходит все целые значения подряд -
+ *    хранится только сколько шагов длится каждый период (ramp_slow, 1 байт на значение периода).
+ * Для RAMP_ACCEL = 100 000 шагов/с² и MAX_SPEED = 20 000 шагов/с это 171 + 242 записи (584 байта) вместо 2091 шага.
+ * С меньшим ускорением обе части длиннее: при ускорении меньше ~50 000 шагов/с² таблица заканчивается раньше,
+ * чем достигнуто 20 000 шагов/с, и скорость движения ограничивается скоростью в конце таблицы.
+ * Торможение проходит ту же таблицу в обратном порядке.
+ *
+ * Стоимость прерывания не зависит от профиля: чтение таблицы, сравнения и счетчики, без деления и умножения
+ * (оценка ~50-70 тактов с прологом). Два прерывания на шаг: при 20 000 шагов/с это ~15-20% процессора.
+ * Максимальная частота ограничена тем, что полупериод (при 25 000 шагов/с - 40 тиков по 0.5 us = 20 us)
+ * должен быть длиннее задержки и длительности прерывания (до ~5 us с учетом других прерываний).
+ *
+ * Перемещения ставятся в очередь (include/spsc_queue.h): main - писатель, прерывание Timer1 забирает следующее
+ * перемещение сразу после последнего шага предыдущего. Каждое перемещение начинается и заканчивается остановкой.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spsc_queue.h"
+
+#define STEP_PIN PB1 // OC1A/PB1(D9)
+#define DIR_PIN PB0 // PB0(D8)
+
+#define TIMER_HZ (F_CPU / 8) // Предделитель Timer1 = 8: 1 тик = 0.5 us
+#define RAMP_ACCEL 100000UL // шагов/с²
+#define MAX_SPEED 20000 // шагов/с
+#define RAMP_FAST_SIZE 224
+#define RAMP_SLOW_SIZE 352 // Вместе с RAMP_FAST_SIZE - 800 байт SRAM
+
+// --- Таблица разгона ---
+
+uint16_t ramp_fast[RAMP_FAST_SIZE]; // Период каждого шага (тиков Timer1)
+uint8_t ramp_slow[RAMP_SLOW_SIZE]; // Шагов с периодом ramp_slow_start - i
+uint16_t ramp_fast_count;
+uint16_t ramp_slow_count;
+uint16_t ramp_slow_start;
+uint16_t ramp_entries; // ramp_fast_count + ramp_slow_count
+uint32_t ramp_steps; // Шагов разгона до скорости движения
+uint16_t ramp_cruise_period; // Период шага на скорости движения
+
+static uint32_t isqrt64(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+// Заполняет таблицу разгона. Если таблица закончилась раньше, чем достигнута max_speed,
+// скорость движения ограничивается скоростью в конце таблицы.
+void ramp_build(uint32_t accel, uint16_t max_speed) {
+    uint16_t cruise = TIMER_HZ / max_speed;
+
+    // c0 = 0.676 * F * sqrt(2 / a) с 8 битами дробной части: c0 * 256 = sqrt((0.676 * F * 256)^2 * 2 / a)
+    const uint64_t c0_factor = (uint64_t)TIMER_HZ * 676 / 1000 * 256;
+    uint32_t c = isqrt64(c0_factor * c0_factor * 2 / accel);
+
+    ramp_fast_count = 0;
+    ramp_slow_count = 0;
+    ramp_steps = 0;
+    ramp_cruise_period = cruise;
+    for (uint32_t n = 1; ; n++) {
+        uint32_t period = (c + 128) >> 8;
+        if (period > 0xFFFF) {
+            period = 0xFFFF; // Медленнее 30 шагов/с таймер не умеет: первые шаги разгона чуть короче
+        }
+        if (period <= cruise) {
+            break;
+        }
+        uint32_t decrement = (2 * c) / (4 * n + 1);
+
+        if (ramp_slow_count) {
+            uint16_t last = ramp_slow_start - (ramp_slow_count - 1);
+            if (period == last && ramp_slow[ramp_slow_count - 1] < 0xFF) {
+                ramp_slow[ramp_slow_count - 1]++;
+            } else if (period == (uint16_t)(last - 1) && ramp_slow_count < RAMP_SLOW_SIZE) {
+                ramp_slow[ramp_slow_count++] = 1;
+            } else {
+                ramp_cruise_period = last; // Таблица закончилась (или шагов с одним периодом больше 255)
+                break;
+            }
+        } else if (decrement < 256 && ramp_fast_count) {
+            ramp_slow_start = period; // Дальше период меняется меньше, чем на тик за шаг
+            ramp_slow[ramp_slow_count++] = 1;
+        } else if (ramp_fast_count < RAMP_FAST_SIZE) {
+            ramp_fast[ramp_fast_count++] = period;
+        } else {
+            ramp_cruise_period = ramp_fast[RAMP_FAST_SIZE - 1];
+            break;
+        }
+        ramp_steps++;
+        c -= decrement;
+    }
+    ramp_entries = ramp_fast_count + ramp_slow_count;
+}
+
+static inline uint16_t ramp_period(uint16_t index) {
+    return index < ramp_fast_count ? ramp_fast[index] : ramp_slow_start - (index - ramp_fast_count);
+}
+
+static inline uint8_t ramp_repeat(uint16_t index) {
+    return index < ramp_fast_count ? 1 : ramp_slow[index - ramp_fast_count];
+}
+
+// --- Очередь перемещений ---
+
+typedef struct {
+    int32_t steps; // Знак - направление
+} move_t;
+
+SPSC_QUEUE(moves, move_t, 8)
+
+// --- Генератор шагов (состояние меняет только прерывание Timer1 и stepper_start() при остановленном таймере) ---
+
+typedef enum {
+    PHASE_ACCEL,
+    PHASE_CRUISE,
+    PHASE_DECEL,
+} phase_t;
+
+volatile bool stepper_running;
+uint32_t stepper_remaining; // Шагов до конца перемещения, включая текущий
+uint32_t stepper_decel_from; // При каком stepper_remaining начинать торможение
+uint32_t stepper_accel_left; // Шагов разгона осталось
+phase_t stepper_phase;
+uint16_t stepper_period;
+uint16_t ramp_index; // Позиция в таблице: запись и номер шага внутри нее
+uint8_t ramp_offset;
+
+static inline uint16_t ramp_forward(void) {
+    uint16_t period = ramp_period(ramp_index);
+    if (++ramp_offset == ramp_repeat(ramp_index)) {
+        ramp_index++;
+        ramp_offset = 0;
+    }
+    return period;
+}
+
+static inline uint16_t ramp_backward(void) {
+    if (ramp_offset == 0) {
+        ramp_index--;
+        ramp_offset = ramp_repeat(ramp_index);
+    }
+    ramp_offset--;
+    return ramp_period(ramp_index);
+}
+
+// Период следующего шага
+static inline uint16_t stepper_next_period(void) {
+    switch (stepper_phase) {
+        case PHASE_ACCEL:
+            stepper_period = ramp_forward();
+            if (--stepper_accel_left == 0) {
+                stepper_phase = PHASE_CRUISE;
+            }
+            break;
+        case PHASE_CRUISE:
+            if (stepper_remaining == stepper_decel_from) {
+                stepper_phase = PHASE_DECEL;
+                stepper_period = ramp_backward();
+            } else if (ramp_index == ramp_entries) {
+                stepper_period = ramp_cruise_period;
+            }
+            // Иначе (треугольник) - средний шаг с периодом последнего шага разгона
+            break;
+        case PHASE_DECEL:
+            stepper_period = ramp_backward();
+            break;
+    }
+    return stepper_period;
+}
+
+// Начинает следующее перемещение из очереди. Вызывается при остановленном таймере.
+static bool stepper_start(void) {
+    move_t move;
+    while (moves_pop(&move)) {
+        if (move.steps == 0) {
+            continue;
+        }
+        if (move.steps > 0) {
+            PORTB |= (1<<DIR_PIN);
+        } else {
+            PORTB &= ~(1<<DIR_PIN);
+            move.steps = -move.steps;
+        }
+        uint32_t steps = move.steps;
+        uint32_t accel = steps / 2 < ramp_steps ? steps / 2 : ramp_steps;
+        stepper_remaining = steps;
+        stepper_accel_left = accel;
+        stepper_decel_from = accel; // Торможение - последние accel шагов
+        stepper_phase = accel ? PHASE_ACCEL : PHASE_CRUISE;
+        ramp_index = 0;
+        ramp_offset = 0;
+        stepper_period = ramp_entries ? ramp_period(0) : ramp_cruise_period; // Для перемещения в 1 шаг
+
+        uint16_t period = stepper_next_period();
+        TCNT1 = 0;
+        OCR1A = (period >> 1) - 1; // Низкий уровень до первого фронта
+        TCCR1A = (1<<COM1A0); // OC1A переключается при совпадении
+        TCCR1B = (1<<WGM12) | (1<<CS11); // CTC, предделитель 8
+        stepper_running = true;
+        return true;
+    }
+    stepper_running = false;
+    return false;
+}
+
+ISR(TIMER1_COMPA_vect) {
+    if (PINB & (1<<STEP_PIN)) {
+        // Фронт: шаг сделан, держим высокий уровень вторую половину периода
+        OCR1A = stepper_period - (stepper_period >> 1) - 1;
+        return;
+    }
+    // Спад: конец шага
+    if (--stepper_remaining == 0) {
+        TCCR1B = 0;
+        TCCR1A = 0; // OC1A отключен, на пине остается низкий уровень из PORTB
+        stepper_start();
+        return;
+    }
+    OCR1A = (stepper_next_period() >> 1) - 1;
+}
+
+// Добавляет перемещение в очередь. false - очередь полна.
+bool stepper_move(int32_t steps) {
+    if (!moves_push((move_t){.steps = steps})) {
+        return false;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (!stepper_running) {
+            stepper_start();
+        }
+    }
+    return true;
+}
+
+int main(void) {
+    DDRB |= (1<<STEP_PIN) | (1<<DIR_PIN);
+    TIMSK1 |= (1<<OCIE1A);
+
+    ramp_build(RAMP_ACCEL, MAX_SPEED);
+    sei();
+
+    while (1) {
+        // Вперед на 20 000 шагов, назад, затем короткие перемещения (треугольный профиль)
+        while (!stepper_move(20000));
+        while (!stepper_move(-20000));
+        for (uint8_t i = 0; i < 4; i++) {
+            while (!stepper_move(200));
+        }
+        while (!stepper_move(-800));
+        while (stepper_running);
+    }
+}
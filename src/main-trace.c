@@ -0,0 +1,222 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Запись трассы событий в кольцевой буфер в RAM (trace recorder).
+ *
+ * printf внутри прерываний TIMER1_CAPT_vect (main-ir-receiver.c) или TIMER0_COMPA_vect (main-blink-timer.c)
+ * занимает сотни микросекунд и полностью меняет поведение программы. Вместо этого каждое событие записывается
+ * в RAM как запись фиксированного размера (4 байта):
+ *  - id       - номер события (1 байт);
+ *  - payload  - данные события (1 байт);
+ *  - timestamp - значение TCNT1 (2 байта, младший байт первым).
+ * Макрос TRACE() - это несколько инструкций ld/st и два ветвления (~30 тактов, ~2 us при 16 MHz).
+ *
+ * Буфер кольцевой: при переполнении новые записи затирают самые старые (последние TRACE_SIZE событий всегда доступны).
+ * TRACE() вызывается только из прерываний (прерывания не вложены друг в друга), из main - TRACE_MAIN() (с запретом прерываний).
+ *
+ * Выгрузка: при получении символа 'd' по USART (1 000 000 бод) запись приостанавливается и буфер передается в двоичном виде:
+ *  "TRC" 0x01 | tick_ns (2 байта) | count (2 байта) | total (4 байта) | count записей (от старых к новым)
+ * tick_ns - длительность тика TCNT1 в наносекундах, total - сколько всего событий было записано (total - count = потеряно).
+ * Декодер для Linux: tools/trace_decode.py (собирает 16-битные метки времени в непрерывную шкалу времени).
+ *
+ * 16-битная метка времени переполняется каждые 32.7 ms (тик 0.5 us). Декодер считает, что между соседними событиями
+ * прошло меньше 32.7 ms, поэтому в программе есть событие TRACE_TICK каждые 16 ms. Чаще не нужно: кадр NEC
+ * (67 фронтов за 67.5 ms) вместе с метками времени помещается в буфер.
+ *
+ * Счетчик total не увеличивается в TRACE(): он считается при выгрузке по числу оборотов кольца (trace_wraps,
+ * увеличивается раз в TRACE_SIZE записей) и позиции записи.
+ *
+ * Программа. Прием команд NEC (как в main-ir-receiver.c) с трассировкой каждого фронта, ошибок декодирования
+ * и принятых команд. Светодиод на PD4 переключается по команде 0x45.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usart_polled.h"
+
+#define LED_PIN PD4 // PD4(D4)
+#define IR_RECEIVER_PIN PB0 // ICP1/PB0(D8)
+
+// --- Трасса ---
+
+// Номера событий (совпадают с EVENTS в tools/trace_decode.py)
+#define TRACE_TICK 1 // payload: младший байт счетчика миллисекунд (каждые TRACE_TICK_MS)
+#define TRACE_IR_EDGE 2 // payload: номер фронта
+#define TRACE_IR_ERROR 3 // payload: номер фронта, на котором длительность не совпала
+#define TRACE_IR_COMMAND 4 // payload: команда
+#define TRACE_DUMP 5 // payload: 0
+
+#define TRACE_SIZE 128 // Записей в буфере (степень двойки), 512 байт RAM
+#define TRACE_MASK (TRACE_SIZE - 1)
+#define TRACE_TICK_NS 500 // Timer1, предделитель 8
+#define TRACE_TICK_MS 16 // Период TRACE_TICK (степень двойки), меньше половины периода переполнения TCNT1
+
+typedef struct {
+    uint8_t id;
+    uint8_t payload;
+    uint16_t timestamp;
+} trace_record_t;
+
+trace_record_t trace_buffer[TRACE_SIZE];
+volatile uint8_t trace_head;
+volatile uint16_t trace_wraps; // Сколько раз trace_head прошел через 0
+volatile bool trace_enabled = true;
+
+#define TRACE(event_id, event_payload) do { \
+    if (trace_enabled) { \
+        uint8_t head = trace_head; \
+        trace_record_t *record = &trace_buffer[head]; \
+        record->id = (event_id); \
+        record->payload = (event_payload); \
+        record->timestamp = TCNT1; \
+        head = (head + 1) & TRACE_MASK; \
+        trace_head = head; \
+        if (head == 0) { \
+            trace_wraps++; \
+        } \
+    } \
+} while (0)
+
+#define TRACE_MAIN(event_id, event_payload) ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { TRACE(event_id, event_payload); }
+
+// Передает буфер трассы. Запись на это время приостановлена, события во время передачи не записываются.
+void trace_dump(void) {
+    trace_enabled = false;
+
+    uint32_t total = (uint32_t)trace_wraps * TRACE_SIZE + trace_head;
+    uint16_t count = total < TRACE_SIZE ? total : TRACE_SIZE;
+    uint8_t index = (trace_head - count) & TRACE_MASK; // Самая старая запись
+    uint16_t tick_ns = TRACE_TICK_NS;
+
+    usart_write_blocking("TRC\x01", 4);
+    usart_write_blocking(&tick_ns, sizeof(tick_ns));
+    usart_write_blocking(&count, sizeof(count));
+    usart_write_blocking(&total, sizeof(total));
+    for (uint16_t i = 0; i < count; i++) {
+        usart_write_blocking(&trace_buffer[index], sizeof(trace_record_t));
+        index = (index + 1) & TRACE_MASK;
+    }
+
+    trace_head = 0;
+    trace_wraps = 0;
+    trace_enabled = true;
+    TRACE_MAIN(TRACE_DUMP, 0);
+}
+
+// --- Прием команд NEC (см. main-ir-receiver.c) ---
+
+#define TICKS_9MS    18000
+#define TICKS_4_5MS  9000
+#define TICKS_560US  1120
+#define TICKS_1690US 3380
+
+#define TOLERANCE_9MS   200
+#define TOLERANCE_4_5MS 200
+#define TOLERANCE_BIT   150
+
+volatile uint16_t ir_last_capture = 0;
+volatile uint8_t ir_counter = 0;
+volatile uint32_t ir_data = 0;
+volatile bool ir_finished = false;
+
+void ir_reset(void) {
+    ir_last_capture = 0;
+    ir_counter = 0;
+    ir_data = 0;
+    ir_finished = false;
+    TCCR1B &= ~(1<<ICES1); // Захват по падающему фронту
+}
+
+static inline bool is_duration_match(uint16_t duration, uint16_t target, uint16_t tolerance) {
+    return (duration > (target - tolerance)) && (duration < (target + tolerance));
+}
+
+ISR(TIMER1_CAPT_vect) {
+    uint16_t current_capture = ICR1;
+    uint16_t duration = current_capture - ir_last_capture;
+    bool is_match;
+
+    if (ir_finished) {
+        return;
+    }
+    TRACE(TRACE_IR_EDGE, ir_counter);
+
+    if (ir_counter == 0) {
+        is_match = true;
+    } else if (ir_counter == 1) {
+        is_match = is_duration_match(duration, TICKS_9MS, TOLERANCE_9MS);
+    } else if (ir_counter == 2) {
+        is_match = is_duration_match(duration, TICKS_4_5MS, TOLERANCE_4_5MS);
+    } else if (ir_counter % 2) {
+        is_match = is_duration_match(duration, TICKS_560US, TOLERANCE_BIT);
+        if (is_match && ir_counter == 67) {
+            ir_finished = true;
+            return;
+        }
+    } else {
+        bool is_bit_1 = is_duration_match(duration, TICKS_1690US, TOLERANCE_BIT + 150);
+        is_match = is_bit_1 || is_duration_match(duration, TICKS_560US, TOLERANCE_BIT);
+        if (is_bit_1) {
+            ir_data |= (uint32_t)1 << ((ir_counter - 4) / 2);
+        }
+    }
+
+    if (is_match) {
+        ir_last_capture = current_capture;
+        ir_counter++;
+        TCCR1B ^= (1<<ICES1);
+    } else {
+        TRACE(TRACE_IR_ERROR, ir_counter);
+        ir_reset();
+    }
+}
+
+volatile uint8_t count_ms;
+
+ISR(TIMER0_COMPA_vect) {
+    count_ms++;
+    if ((count_ms & (TRACE_TICK_MS - 1)) == 0) {
+        TRACE(TRACE_TICK, count_ms);
+    }
+}
+
+int main(void) {
+    DDRD |= (1<<LED_PIN);
+
+    usart_init(true);
+
+    TCCR1A = 0;
+    TCCR1B = (1<<CS11); // Предделитель 8 (0.5 us/тик)
+    TIMSK1 |= (1<<ICIE1);
+    ir_reset();
+
+    TCCR0A = (1<<WGM01); // Timer0 CTC, 1 ms
+    OCR0A = 249;
+    TIMSK0 = (1<<OCIE0A);
+    TCCR0B = (1<<CS01) | (1<<CS00);
+
+    sei();
+
+    while (1) {
+        if (ir_finished) {
+            uint32_t data = ir_data;
+            uint8_t address = data & 0xFF;
+            uint8_t command = (data >> 16) & 0xFF;
+            if (((data >> 8) & 0xFF) == (uint8_t)~address && (data >> 24) == (uint8_t)~command) {
+                TRACE_MAIN(TRACE_IR_COMMAND, command);
+                if (address == 0x00 && command == 0x45) {
+                    PORTD ^= (1<<LED_PIN);
+                }
+            }
+            ir_reset();
+        }
+
+        if (usart_read() == 'd') {
+            trace_dump();
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Светофор из main-traffic-light.c, переписанный на шаблонах lib/gpio.
+ *
+ * В main-traffic-light.c функция turn_led() получает номер пина в переменной, поэтому маска (1<<pin)
+ * вычисляется сдвигом в цикле при каждом вызове, а каждый шаг - это три отдельных чтения-изменения-записи PORTB.
+ * Здесь пины - типы, маски известны при компиляции, и шаг светофора - одна запись группы
+ * (ожидается in, andi, andi, or, out - оценка, не проверенная листингом; см. lib/gpio/gpio.h).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <gpio.h>
+
+typedef gpio::Pin<gpio::PortB, PB3> LedRed; // PB3(D11)
+typedef gpio::Pin<gpio::PortB, PB2> LedYellow; // PB2(D10)
+typedef gpio::Pin<gpio::PortB, PB1> LedGreen; // PB1(D9)
+typedef gpio::PinGroup<LedRed, LedYellow, LedGreen> Leds;
+
+volatile uint64_t timer_counter_ms; // МК никогда не превысит этот счетчик (миллионы лет)
+
+ISR(TIMER0_COMPA_vect) {
+    timer_counter_ms++;
+}
+
+#define LONG_DELAY 2000
+#define SHORT_DELAY 400
+
+typedef struct {
+    const uint8_t state; // Биты PORTB
+    const uint16_t delay;
+} step_t;
+
+const step_t STEPS[] = {
+    {LedGreen::mask, LONG_DELAY},
+    {0, SHORT_DELAY},
+    {LedGreen::mask, SHORT_DELAY},
+    {0, SHORT_DELAY},
+    {LedGreen::mask, SHORT_DELAY},
+    {0, SHORT_DELAY},
+    {LedGreen::mask, SHORT_DELAY},
+    {LedYellow::mask, LONG_DELAY},
+    {LedRed::mask, LONG_DELAY},
+};
+
+int main(void) {
+    Leds::output(); // Настраиваем пины на выход
+
+    TIMSK0 |= (1<<OCIE0A); // Включить прерывание при совпадении для Timer0
+    TCCR0A |= (1<<WGM01); // Задаем режим CTC для Timer0
+    OCR0A = 250; // Задаем значение для регистра совпадения: T(250) = 4 us * 250 = 1000 us = 1 ms
+
+    sei(); // Разрешаем прерывания
+
+    TCCR0B |= (1<<CS01) | (1<<CS00); // Задаем предделитель = 64 (~1ms) (CS02=0, CS01=1, CS00=1)
+
+    uint64_t delay_finish = 0;
+    uint8_t step_index = 0;
+    uint8_t steps_size = sizeof(STEPS) / sizeof(STEPS[0]);
+    bool is_start = true;
+
+    while (1) {
+        if (delay_finish <= timer_counter_ms) {
+            step_t step = STEPS[step_index];
+            Leds::write(step.state);
+            if (is_start) {
+                is_start = false;
+                delay_finish = timer_counter_ms + step.delay;
+            } else {
+                is_start = true;
+                step_index = step_index < (steps_size - 1) ? step_index + 1 : 0;
+            }
+        }
+    }
+}
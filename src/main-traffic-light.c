@@ -12,8 +12,7 @@
  * Таймер счетчик после запуска увеличивает значение переменной через каждую миллисекунду.
  */
 
-#include <avr/io.h>
-#include <avr/interrupt.h>
+#include "hal.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -75,7 +74,7 @@ int main(void) {
     uint8_t steps_size = sizeof(STEPS) / sizeof(STEPS[0]);
     bool is_start = true;
 
-    while(1) {
+    while (hal_running()) {
         if (delay_finish <= timer_counter_ms) {
             step_t step = STEPS[step_index];
             turn_led(LED_GREEN_PIN, step.state & (1 << GREEN_BIT));
@@ -0,0 +1,188 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Обмен с устройствами I2C через ведущий TWI на прерываниях (include/twi_master.h): EEPROM 24C02 и датчик
+ * температуры LM75. Основной цикл не ждет шину: транзакции ставятся в очередь, результат приходит в callback.
+ *
+ * Подключение: SDA - PC4(A4), SCL - PC5(A5), подтяжка 2.2K к 5 V на обеих линиях (шина 400 kHz).
+ *  - 24C02 (адрес 0x50, A0..A2 = GND);
+ *  - LM75 (адрес 0x48, A0..A2 = GND);
+ *  - PB5(D13) - светодиод "EEPROM проверена": записанная страница прочитана обратно без ошибок;
+ *  - PD4(D4) - мигает при каждом чтении температуры (10 раз в секунду);
+ *  - PD5(D5) - горит, если была ошибка (счетчики по видам - в twi_errors).
+ *
+ * Последовательность:
+ *  1. Запись страницы 8 байт в EEPROM с адреса 0x10 (адрес ячейки и данные - одна транзакция записи).
+ *  2. Ожидание окончания записи (до 5 ms): EEPROM не отвечает на свой адрес, пока пишет, поэтому раз в 1 ms
+ *     отправляется транзакция из одного адреса, пока не будет ACK (acknowledge polling).
+ *  3. Чтение страницы (запись адреса ячейки, повторный START, чтение 8 байт) и сравнение.
+ *  Параллельно раз в 100 ms - чтение температуры (регистр 0, 2 байта). Транзакции EEPROM и датчика стоят
+ *  в одной очереди и идут по шине подряд.
+ *
+ * Сборка на компьютере с моделью шины: pio run -e native-twi, затем
+ *  HAL_NATIVE_TWI_MEMORY=0x50,0x48 HAL_NATIVE_TRACE=1 .pio/build/native-twi/program
+ * Без HAL_NATIVE_TWI_MEMORY устройств на шине нет (NACK на адрес), HAL_NATIVE_TWI_FAULT=stuck:30 проверяет
+ * восстановление зависшей шины, HAL_NATIVE_TWI_FAULT=bus_error:12 - ошибку шины (см. lib/hal_native).
+ */
+
+#include "hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "twi_master.h"
+#include "power_manager.h"
+
+#define LED_EEPROM_PIN PB5 // PB5(D13)
+#define LED_SENSOR_PIN PD4 // PD4(D4)
+#define LED_ERROR_PIN PD5 // PD5(D5)
+
+#define EEPROM_ADDRESS 0x50
+#define EEPROM_CELL 0x10 // Начало страницы (у 24C02 страница 8 байт)
+#define SENSOR_ADDRESS 0x48
+#define SENSOR_PERIOD_MS 100
+
+volatile uint16_t now_ms;
+volatile uint8_t twi_errors[TWI_TIMEOUT + 1]; // По значениям twi_status_t
+
+ISR(TIMER0_COMPA_vect) {
+    now_ms++;
+    twi_tick();
+}
+
+// --- EEPROM ---
+
+typedef enum {
+    EEPROM_WRITE,
+    EEPROM_POLL,
+    EEPROM_READ,
+    EEPROM_DONE,
+} eeprom_step_t;
+
+static const uint8_t eeprom_pattern[8] = {0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x23, 0x45, 0x67};
+static uint8_t eeprom_page[1 + 8]; // Адрес ячейки и данные
+static uint8_t eeprom_cell = EEPROM_CELL;
+static uint8_t eeprom_read[8];
+volatile eeprom_step_t eeprom_step;
+
+static void on_twi_error(twi_status_t status) {
+    if (twi_errors[status] != 0xFF) {
+        twi_errors[status]++;
+    }
+    PORTD |= (1<<LED_ERROR_PIN);
+}
+
+static void on_eeprom(twi_transaction_t *transaction) {
+    switch (eeprom_step) {
+        case EEPROM_WRITE:
+            if (transaction->status == TWI_OK) {
+                eeprom_step = EEPROM_POLL;
+            } else {
+                on_twi_error(transaction->status);
+            }
+            break;
+        case EEPROM_POLL:
+            if (transaction->status == TWI_OK) {
+                eeprom_step = EEPROM_READ;
+            } else if (transaction->status != TWI_NACK_ADDRESS) { // NACK - EEPROM еще пишет, это не ошибка
+                on_twi_error(transaction->status);
+            }
+            break;
+        case EEPROM_READ:
+            if (transaction->status == TWI_OK) {
+                if (memcmp(eeprom_read, eeprom_pattern, sizeof(eeprom_read)) == 0) {
+                    PORTB |= (1<<LED_EEPROM_PIN);
+                }
+                eeprom_step = EEPROM_DONE;
+            } else {
+                on_twi_error(transaction->status);
+            }
+            break;
+        case EEPROM_DONE:
+            break;
+    }
+}
+
+static twi_transaction_t eeprom_write = {
+    .address = EEPROM_ADDRESS, .write_data = eeprom_page, .write_length = sizeof(eeprom_page),
+    .callback = on_eeprom,
+};
+static twi_transaction_t eeprom_poll = {
+    .address = EEPROM_ADDRESS,
+    .callback = on_eeprom,
+};
+static twi_transaction_t eeprom_verify = {
+    .address = EEPROM_ADDRESS, .write_data = &eeprom_cell, .write_length = 1,
+    .read_data = eeprom_read, .read_length = sizeof(eeprom_read),
+    .callback = on_eeprom,
+};
+
+// --- Датчик температуры ---
+
+static uint8_t sensor_register = 0x00; // Температура
+static uint8_t sensor_value[2];
+volatile int16_t temperature_half_c; // В половинах градуса
+
+static void on_sensor(twi_transaction_t *transaction) {
+    if (transaction->status == TWI_OK) {
+        temperature_half_c = (int16_t)((sensor_value[0] << 8) | sensor_value[1]) >> 7;
+        PORTD ^= (1<<LED_SENSOR_PIN);
+    } else {
+        on_twi_error(transaction->status);
+    }
+}
+
+static twi_transaction_t sensor_read = {
+    .address = SENSOR_ADDRESS, .write_data = &sensor_register, .write_length = 1,
+    .read_data = sensor_value, .read_length = sizeof(sensor_value),
+    .callback = on_sensor,
+};
+
+static uint16_t millis(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t value = now_ms;
+    SREG = sreg;
+    return value;
+}
+
+int main(void) {
+    pm_init(); // TWI захватывает twi_init()
+    DDRB |= (1<<LED_EEPROM_PIN);
+    DDRD |= (1<<LED_SENSOR_PIN) | (1<<LED_ERROR_PIN);
+
+    pm_acquire(PM_TIMER0);
+    // Timer0: CTC, предделитель 64, 250 тиков по 4 us = 1 ms
+    TCCR0A = (1<<WGM01);
+    OCR0A = 249;
+    TIMSK0 = (1<<OCIE0A);
+    TCCR0B = (1<<CS01) | (1<<CS00);
+
+    twi_init(400000);
+    sei();
+
+    eeprom_page[0] = EEPROM_CELL;
+    memcpy(&eeprom_page[1], eeprom_pattern, sizeof(eeprom_pattern));
+    eeprom_step = EEPROM_WRITE;
+    twi_submit(&eeprom_write);
+
+    uint16_t poll_ms = millis();
+    uint16_t sensor_ms = millis();
+    while (hal_running()) {
+        uint16_t now = millis();
+
+        // Транзакцию можно поставить снова, только когда предыдущая с ней завершена
+        if (eeprom_step == EEPROM_POLL && eeprom_poll.status != TWI_PENDING && (uint16_t)(now - poll_ms) >= 1) {
+            poll_ms = now;
+            twi_submit(&eeprom_poll);
+        }
+        if (eeprom_step == EEPROM_READ && eeprom_verify.status != TWI_PENDING) { // Первый раз или повтор после ошибки
+            twi_submit(&eeprom_verify);
+        }
+
+        if ((uint16_t)(now - sensor_ms) >= SENSOR_PERIOD_MS && sensor_read.status != TWI_PENDING) {
+            sensor_ms = now;
+            twi_submit(&sensor_read);
+        }
+    }
+}
@@ -0,0 +1,321 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Драйвер USART0 на прерываниях с кольцевыми буферами.
+ *
+ * USART0 подключен к USB-UART преобразователю платы (CH340): TXD - PD1 (D1), RXD - PD0 (D0).
+ * Скорость задается регистром UBRR0. В режиме двойной скорости (U2X0=1):
+ *  UBRR0 = F_CPU / (8 * BAUD) - 1
+ *  2 000 000 бод: UBRR0 = 0 (без ошибки)
+ *  1 000 000 бод: UBRR0 = 1 (без ошибки)
+ *    115 200 бод: UBRR0 = 16 (ошибка 2.1%)
+ * На 1 и 2 Мбод частота 16 MHz делится без остатка, поэтому эти скорости надежнее, чем 115200.
+ *
+ * Передача:
+ * - usart_write() копирует байты в кольцевой буфер и сразу возвращает, сколько байт поместилось (не блокирует);
+ * - usart_send_buffer() передает буфер программы без копирования. Буфер нельзя менять, пока usart_tx_busy() возвращает true;
+ * - usart_write_blocking() ждет места в буфере - блокирующий вызов нужно выбрать явно.
+ * Прерывание USART_UDRE_vect (регистр UDR0 пуст) отправляет следующий байт и выключается, когда отправлять нечего.
+ *
+ * Прием: прерывание USART_RX_vect кладет байт в кольцевой буфер, usart_read() забирает байт без ожидания.
+ * Переполнение буфера приема и ошибки кадра считаются в usart_rx_errors.
+ *
+ * Нагрузка на процессор: при 2 Мбод байт (10 бит) передается за 5 us = 80 тактов, обработчик UDRE занимает ~40 тактов,
+ * то есть ~50% процессорного времени. Одновременные прием и передача на 2 Мбод почти полностью занимают процессор,
+ * для полного дуплекса используйте 1 Мбод.
+ *
+ * Программа. При запуске измеряет реальную скорость передачи и загрузку процессора для кольцевого буфера
+ * и для передачи без копирования, и печатает результат. Затем раз в 100 ms печатает значение АЦП на A5
+ * и отвечает эхом на принятые символы.
+ * Терминал: 2 000 000 бод, 8N1 (например, `pio device monitor -b 2000000`).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h> // NULL definition
+
+#include "power_manager.h"
+
+#define USART_BAUD 2000000UL
+#define USART_UBRR (F_CPU / (8 * USART_BAUD) - 1)
+
+#define USART_TX_SIZE 64 // Степень двойки
+#define USART_RX_SIZE 32 // Степень двойки
+#define USART_TX_MASK (USART_TX_SIZE - 1)
+#define USART_RX_MASK (USART_RX_SIZE - 1)
+
+uint8_t usart_tx_buffer[USART_TX_SIZE];
+volatile uint8_t usart_tx_head; // Пишет только main
+volatile uint8_t usart_tx_tail; // Пишет только прерывание
+
+const uint8_t *volatile usart_tx_ptr; // Буфер программы, передаваемый без копирования
+volatile uint16_t usart_tx_len;
+
+uint8_t usart_rx_buffer[USART_RX_SIZE];
+volatile uint8_t usart_rx_head; // Пишет только прерывание
+volatile uint8_t usart_rx_tail; // Пишет только main
+volatile uint8_t usart_rx_errors;
+
+ISR(USART_UDRE_vect) {
+    const uint8_t *ptr = usart_tx_ptr;
+    if (ptr != NULL) {
+        UDR0 = *ptr;
+        uint16_t len = usart_tx_len - 1;
+        usart_tx_len = len;
+        usart_tx_ptr = len ? ptr + 1 : NULL;
+        return;
+    }
+
+    uint8_t tail = usart_tx_tail;
+    if (tail != usart_tx_head) {
+        UDR0 = usart_tx_buffer[tail];
+        usart_tx_tail = (tail + 1) & USART_TX_MASK;
+    } else {
+        UCSR0B &= ~(1<<UDRIE0); // Нечего отправлять
+    }
+}
+
+ISR(USART_RX_vect) {
+    uint8_t status = UCSR0A; // Флаги ошибок нужно прочитать до UDR0
+    uint8_t data = UDR0;
+    uint8_t head = usart_rx_head;
+    uint8_t next = (head + 1) & USART_RX_MASK;
+
+    if ((status & ((1<<FE0) | (1<<DOR0))) || next == usart_rx_tail) {
+        usart_rx_errors++;
+        return;
+    }
+    usart_rx_buffer[head] = data;
+    usart_rx_head = next;
+}
+
+void usart_init(void) {
+    pm_acquire(PM_USART0); // Регистры USART доступны только при включенном тактировании
+    UBRR0 = USART_UBRR;
+    UCSR0A = (1<<U2X0); // Двойная скорость
+    UCSR0C = (1<<UCSZ01) | (1<<UCSZ00); // 8 бит данных, без контроля четности, 1 стоп-бит
+    UCSR0B = (1<<RXEN0) | (1<<TXEN0) | (1<<RXCIE0);
+}
+
+bool usart_tx_busy(void) {
+    return usart_tx_ptr != NULL || usart_tx_head != usart_tx_tail;
+}
+
+// Копирует в буфер передачи сколько поместится. Возвращает количество записанных байт.
+uint16_t usart_write(const void *data, uint16_t len) {
+    const uint8_t *bytes = data;
+    uint8_t head = usart_tx_head;
+    uint16_t count = 0;
+
+    while (count < len) {
+        uint8_t next = (head + 1) & USART_TX_MASK;
+        if (next == usart_tx_tail) {
+            break; // Буфер заполнен
+        }
+        usart_tx_buffer[head] = bytes[count++];
+        head = next;
+    }
+    usart_tx_head = head;
+    UCSR0B |= (1<<UDRIE0); // Если прерывание успело выключить UDRIE0 (буфер был пуст), включаем его снова
+    return count;
+}
+
+// Ждет, пока все байты не будут записаны в буфер передачи.
+void usart_write_blocking(const void *data, uint16_t len) {
+    const uint8_t *bytes = data;
+    while (len > 0) {
+        uint16_t count = usart_write(bytes, len);
+        bytes += count;
+        len -= count;
+    }
+}
+
+// Передает буфер без копирования. Возвращает false, если передача еще идет (порядок байт сохраняется).
+bool usart_send_buffer(const void *data, uint16_t len) {
+    if (len == 0 || usart_tx_busy()) {
+        return false;
+    }
+    // UDRIE0 может быть еще включен (прерывание выключит его, отправив последний байт из кольцевого буфера),
+    // поэтому 16-битные usart_tx_len и usart_tx_ptr записываются с запрещенными прерываниями
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        usart_tx_len = len;
+        usart_tx_ptr = data;
+        UCSR0B |= (1<<UDRIE0);
+    }
+    return true;
+}
+
+// Возвращает принятый байт или -1, если буфер пуст.
+int16_t usart_read(void) {
+    uint8_t tail = usart_rx_tail;
+    if (tail == usart_rx_head) {
+        return -1;
+    }
+    uint8_t data = usart_rx_buffer[tail];
+    usart_rx_tail = (tail + 1) & USART_RX_MASK;
+    return data;
+}
+
+void usart_print(const char *str) {
+    uint16_t len = 0;
+    while (str[len]) {
+        len++;
+    }
+    usart_write_blocking(str, len);
+}
+
+void usart_print_uint(uint32_t value) {
+    char buffer[11];
+    uint8_t i = sizeof(buffer) - 1;
+    buffer[i] = '\0';
+    do {
+        buffer[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    usart_print(&buffer[i]);
+}
+
+// --- Измерение скорости и загрузки процессора ---
+// Timer1 с предделителем 64 (4 us) измеряет время.
+// Загрузка процессора: сколько итераций пустого цикла main успевает выполнить за одно и то же окно времени
+// без передачи и во время передачи (остальное время заняли прерывания драйвера).
+
+#define BENCH_BYTES 2048
+#define BENCH_US_PER_TICK 4
+#define BENCH_WINDOW_TICKS 40 // 160 us, меньше времени передачи полного кольцевого буфера (63 байта = 315 us при 2 Мбод)
+
+uint8_t bench_data[256];
+
+uint32_t bench_idle_loops(void) {
+    uint32_t loops = 0;
+    uint16_t start = TCNT1;
+    while ((uint16_t)(TCNT1 - start) < BENCH_WINDOW_TICKS) {
+        loops++;
+    }
+    return loops;
+}
+
+uint8_t bench_cpu_percent(uint32_t idle_loops, uint32_t busy_loops) {
+    return busy_loops < idle_loops ? 100 - busy_loops * 100 / idle_loops : 0;
+}
+
+uint32_t bench_bytes_per_second(uint16_t ticks) {
+    return BENCH_BYTES * 1000000UL / ((uint32_t)ticks * BENCH_US_PER_TICK);
+}
+
+void bench_wait_tx(void) {
+    while (usart_tx_busy());
+    while (!(UCSR0A & (1<<UDRE0))); // Последний байт ушел в сдвиговый регистр
+}
+
+// Передача через кольцевой буфер: основной цикл дописывает данные, пока есть место
+uint32_t bench_ring_throughput(void) {
+    uint16_t sent = 0;
+    uint16_t start = TCNT1;
+    while (sent < BENCH_BYTES) {
+        uint8_t offset = sent % sizeof(bench_data);
+        sent += usart_write(&bench_data[offset], sizeof(bench_data) - offset);
+    }
+    bench_wait_tx();
+    return bench_bytes_per_second(TCNT1 - start);
+}
+
+// Передача без копирования: основной цикл только ставит следующий буфер в очередь
+uint32_t bench_zero_copy_throughput(void) {
+    uint16_t sent = 0;
+    uint16_t start = TCNT1;
+    while (sent < BENCH_BYTES) {
+        if (usart_send_buffer(bench_data, sizeof(bench_data))) {
+            sent += sizeof(bench_data);
+        }
+    }
+    bench_wait_tx();
+    return bench_bytes_per_second(TCNT1 - start);
+}
+
+void bench_print(const char *name, uint32_t bytes_per_second, uint8_t cpu_percent) {
+    usart_print(name);
+    usart_print(": ");
+    usart_print_uint(bytes_per_second);
+    usart_print(" B/s, CPU ");
+    usart_print_uint(cpu_percent);
+    usart_print("%\r\n");
+}
+
+void bench_run(void) {
+    for (uint16_t i = 0; i < sizeof(bench_data); i++) {
+        bench_data[i] = (i % 64 == 63) ? '\n' : ' ' + i % 64; // Печатные символы, чтобы не мешать терминалу
+    }
+
+    uint32_t idle_loops = bench_idle_loops();
+
+    usart_write(bench_data, USART_TX_SIZE - 1);
+    uint8_t ring_cpu = bench_cpu_percent(idle_loops, bench_idle_loops());
+    bench_wait_tx();
+
+    usart_send_buffer(bench_data, sizeof(bench_data));
+    uint8_t zero_copy_cpu = bench_cpu_percent(idle_loops, bench_idle_loops());
+    bench_wait_tx();
+
+    uint32_t ring_speed = bench_ring_throughput();
+    uint32_t zero_copy_speed = bench_zero_copy_throughput();
+
+    usart_print("\r\nbaud ");
+    usart_print_uint(USART_BAUD);
+    usart_print(", max ");
+    usart_print_uint(USART_BAUD / 10);
+    usart_print(" B/s\r\n");
+    bench_print("ring", ring_speed, ring_cpu);
+    bench_print("zero-copy", zero_copy_speed, zero_copy_cpu);
+}
+
+volatile uint8_t count_ms;
+
+ISR(TIMER0_COMPA_vect) {
+    count_ms++;
+}
+
+int main(void) {
+    pm_init(); // Тактирование включается только модулям, которые захвачены ниже
+    usart_init();
+
+    pm_acquire(PM_TIMER1);
+    TCCR1B = (1<<CS11) | (1<<CS10); // Timer1, prescaler = 64 (4 us)
+
+    sei();
+
+    bench_run();
+
+    // ADC5/PC5 (A5), опорное напряжение AVcc, ADC Prescaler = 128
+    pm_acquire(PM_ADC);
+    ADMUX = (1<<REFS0) | (1<<MUX2) | (1<<MUX0);
+    ADCSRA = (1<<ADEN) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0);
+
+    pm_acquire(PM_TIMER0);
+    TCCR0A = (1<<WGM01); // Timer0 CTC, 1 ms
+    OCR0A = 249;
+    TIMSK0 = (1<<OCIE0A);
+    TCCR0B = (1<<CS01) | (1<<CS00);
+
+    uint8_t report_ms = 0;
+
+    while (1) {
+        int16_t c = usart_read();
+        if (c >= 0) {
+            uint8_t byte = c;
+            usart_write(&byte, 1); // Эхо (если буфер полон, символ теряется - main не блокируется)
+        }
+
+        if ((uint8_t)(count_ms - report_ms) >= 100) {
+            report_ms += 100;
+            ADCSRA |= (1<<ADSC);
+            while (ADCSRA & (1<<ADSC));
+            usart_print("adc ");
+            usart_print_uint(ADC);
+            usart_print("\r\n");
+        }
+    }
+}
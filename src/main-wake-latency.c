@@ -0,0 +1,175 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Измерение задержки пробуждения (от события до первой инструкции обработчика) для режимов сна
+ * Idle, ADC Noise Reduction, Power-save, Standby, Power-down и выбор режима по допустимой задержке
+ * (include/sleep_latency.h).
+ *
+ * В глубоких режимах таймеры на clkIO стоят, поэтому момент события нельзя отметить таймером напрямую.
+ * Событие - прерывание сторожевого таймера (WDT): его генератор 128 kHz работает во всех режимах, и прерывания
+ * идут с периодом P (16 ms), который не зависит от того, когда проснулся процессор. Timer1 (предделитель 8,
+ * 0.5 us) работает только в Idle. Один замер - четыре прерывания WDT подряд, обработчик запоминает TCNT1:
+ *  t0 - сон Idle, t1 - сон Idle: P = t1 - t0 (задержки Idle в обоих одинаковы);
+ *  tx - сон в измеряемом режиме: обработчик опоздал на L (пока генератор запускался, Timer1 стоял);
+ *  t2 - сон Idle: t2 - tx = P - L, отсюда L = P - (t2 - tx).
+ * Получается задержка относительно Idle (SLEEP_WAKE_CYCLES по документации прибавляется). Фаза WDT не связана
+ * с тактом процессора, поэтому среднее по WAKE_ROUNDS замерам точнее тика Timer1.
+ *
+ * Результаты печатаются в USART (1 000 000 бод) и записываются в sleep_levels вместо значений из документации:
+ *  level=<режим> latency_cycles=<такты> latency_us=<us> datasheet_us=<us по документации>
+ * Затем для нескольких допустимых задержек печатается выбранный по задержке режим (bound_us=... level=...).
+ *
+ * После измерения программа отпускает Timer1 и USART (power_manager.h) и спит в самом глубоком режиме
+ * с задержкой не больше WAKE_BOUND_US (для 100 us - Standby: генератор не останавливается) и мигает светодиодом по нажатию кнопки
+ * (INT0/PD2/D2 на GND; прерывание по низкому уровню будит и из Standby, и из Power-down).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/delay.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sleep_latency.h"
+#include "usart_polled.h"
+
+#define LED_PIN PB5       // PB5(D13)
+#define INTERRUPT_PIN PD2 // INT0/PD2(D2)
+
+#define WAKE_ROUNDS 16 // Замеров на режим (4 периода WDT по 16 ms на замер)
+#define WAKE_BOUND_US 100
+
+static const char *const LEVEL_NAMES[SLEEP_LEVELS] = {
+    [SLEEP_LEVEL_PWR_DOWN_BOD_OFF] = "power-down-bod-off",
+    [SLEEP_LEVEL_PWR_DOWN] = "power-down",
+    [SLEEP_LEVEL_PWR_SAVE] = "power-save",
+    [SLEEP_LEVEL_STANDBY] = "standby",
+    [SLEEP_LEVEL_ADC] = "adc-noise-reduction",
+    [SLEEP_LEVEL_IDLE] = "idle",
+};
+
+// --- Измерение ---
+
+volatile uint16_t wdt_stamp;
+volatile bool wdt_fired;
+
+ISR(WDT_vect) {
+    wdt_stamp = TCNT1; // Первая инструкция после пролога: одинаковое смещение во всех режимах
+    wdt_fired = true;
+}
+
+// Спит на уровне level до прерывания WDT и возвращает TCNT1 из обработчика
+uint16_t sleep_until_wdt(sleep_level_index_t level) {
+    wdt_fired = false;
+    while (!wdt_fired) {
+        sleep_at(level);
+    }
+    return wdt_stamp;
+}
+
+// Средняя задержка уровня level относительно Idle, в тактах
+uint32_t measure_level(sleep_level_index_t level) {
+    int32_t sum = 0; // В тиках Timer1
+    sleep_until_wdt(SLEEP_LEVEL_IDLE); // Начать с фронта WDT
+    for (uint8_t i = 0; i < WAKE_ROUNDS; i++) {
+        uint16_t t0 = sleep_until_wdt(SLEEP_LEVEL_IDLE);
+        uint16_t t1 = sleep_until_wdt(SLEEP_LEVEL_IDLE);
+        uint16_t tx = sleep_until_wdt(level);
+        uint16_t t2 = sleep_until_wdt(SLEEP_LEVEL_IDLE);
+        sum += (int32_t)(uint16_t)(t1 - t0) - (uint16_t)(t2 - tx);
+    }
+    if (sum < 0) {
+        sum = 0; // Шум в пределах тика
+    }
+    return (uint32_t)sum * 8 / WAKE_ROUNDS;
+}
+
+void print_level(sleep_level_index_t level, uint32_t cycles, uint16_t datasheet_cycles) {
+    usart_print_blocking("level=");
+    usart_print_blocking(LEVEL_NAMES[level]);
+    usart_print_blocking(" latency_cycles=");
+    usart_print_uint_blocking(cycles);
+    usart_print_blocking(" latency_us=");
+    usart_print_uint_blocking(cycles / (F_CPU / 1000000));
+    usart_print_blocking(" datasheet_us=");
+    usart_print_uint_blocking(datasheet_cycles / (F_CPU / 1000000));
+    usart_print_blocking("\r\n");
+}
+
+void benchmark(void) {
+    pm_acquire(PM_TIMER1);
+    // Timer1: предделитель 8, 0.5 us на тик, период WDT 16 ms = 32 000 тиков помещается в 16 бит
+    TCCR1A = 0;
+    TCCR1B = (1<<CS11);
+
+    // WDT: только прерывание (без сброса), 16 ms
+    cli();
+    WDTCSR = (1<<WDCE) | (1<<WDE);
+    WDTCSR = (1<<WDIE);
+    sei();
+
+    for (uint8_t level = 0; level < SLEEP_LEVELS; level++) {
+        uint32_t cycles = level == SLEEP_LEVEL_IDLE ? 0 : measure_level(level);
+        cycles += SLEEP_WAKE_CYCLES;
+        print_level(level, cycles, sleep_levels[level].latency_cycles);
+        usart_flush_blocking();
+        sleep_levels[level].latency_cycles = cycles > UINT16_MAX ? UINT16_MAX : cycles;
+    }
+
+    cli();
+    WDTCSR = (1<<WDCE) | (1<<WDE);
+    WDTCSR = 0;
+    sei();
+    TCCR1B = 0;
+    pm_release(PM_TIMER1);
+
+    const uint16_t bounds[] = {1, 10, 100, 1000, 2000};
+    for (uint8_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+        usart_print_blocking("bound_us=");
+        usart_print_uint_blocking(bounds[i]);
+        usart_print_blocking(" level=");
+        usart_print_blocking(LEVEL_NAMES[sleep_level_for_latency(bounds[i])]); // USART еще захвачен
+        usart_print_blocking("\r\n");
+    }
+    usart_flush_blocking();
+    pm_release(PM_USART0); // Дальше USART не нужен: иначе sleep_bounded() выбрал бы только Idle
+}
+
+// --- Кнопка ---
+
+volatile bool is_interrupt_button = false;
+
+ISR(INT0_vect) {
+    EIMSK &= ~(1<<INT0); // Прерывание по низкому уровню повторяется пока кнопка нажата, отключаем его до обработки
+    is_interrupt_button = true;
+}
+
+int main(void) {
+    DDRB |= (1<<LED_PIN);
+    PORTD |= (1<<INTERRUPT_PIN); // Подтягиваем PD2 к high
+    pm_init(); // Все модули выключены (и аналоговый компаратор), пока их не захватят
+
+    pm_acquire(PM_USART0);
+    usart_init(false);
+    sei();
+
+    benchmark();
+
+    EIMSK |= (1<<INT0); // Прерывание по низкому уровню (ISC01=0, ISC00=0)
+
+    while (1) {
+        sleep_bounded(WAKE_BOUND_US);
+
+        if (is_interrupt_button) {
+            is_interrupt_button = false;
+            PORTB |= (1<<LED_PIN);
+            _delay_ms(200);
+            PORTB &= ~(1<<LED_PIN);
+            while (!(PIND & (1<<INTERRUPT_PIN))); // Ждем отпускания
+            _delay_ms(20);
+            EIFR = (1<<INTF0);
+            EIMSK |= (1<<INT0);
+        }
+    }
+}
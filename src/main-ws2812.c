@@ -0,0 +1,221 @@
+/**
+ * Пример для Arduino Nano.
+ *
+ * Адресная светодиодная лента WS2812/WS2812B (NeoPixel): программная передача с точным отсчетом тактов.
+ *
+ * DIN ленты - PB0(D8) через резистор 330 Ом, питание ленты - отдельный источник 5 V (до 60 mA на светодиод),
+ * общий GND с Arduino.
+ *
+ * Протокол: 24 бита на светодиод (G, R, B, старший бит первым), 800 kHz - бит длится 1.25 us = 20 тактов.
+ * Бит начинается фронтом; "0" - высокий уровень T0H = 6 тактов (375 ns, допуск 250-550 ns),
+ * "1" - T1H = 13 тактов (812 ns, допуск 650-950 ns). Низкий уровень между битами может растягиваться
+ * до ~5 us (измерения Josh Levine, "NeoPixels Revealed"), пауза больше 50 us (WS2812B новых партий - 280 us)
+ * защелкивает цвета - конец кадра.
+ * Все такты отсчитывает цикл на ассемблере ws2812_send(): у таймеров нет свободных каналов для 20-тактового
+ * периода с двумя разными скважностями, а SPI/USART в режиме SPI дает лишние паузы между байтами.
+ *
+ * Кадр в памяти сжат, поэтому светодиодов может быть больше, чем позволяет 2 KB SRAM (3 байта на светодиод):
+ *  - палитра: 16 цветов (48 байт) и 4 бита на светодиод - 600 светодиодов занимают 300 байт вместо 1800.
+ *    Анимация сменой палитры (вращение цветов) не трогает пиксели вовсе;
+ *  - RLE во flash: пары (длина серии, индекс палитры) - кадр любой длины из нескольких десятков байт.
+ * Распаковка идет между светодиодами: пауза между пикселями растягивает низкий уровень последнего бита
+ * на время распаковки (оценка ~40 тактов, 2.5 us - меньше 5 us).
+ *
+ * Запрет прерываний (blackout): весь кадр, иначе прерывание длиннее ~5 us разорвет кадр (лента защелкнет
+ * половину или примет следующий бит за начало). 30 us на светодиод: 600 светодиодов - 18 ms.
+ * Прерывания, которые поднялись за это время, выполнятся после кадра (по одному на источник, остальные
+ * теряются: тик Timer0 1 ms пропустит ~17 тиков). USART на прием без аппаратного буфера больше 2 байт
+ * на 9600 бод тоже теряет данные. Если это важно - несколько коротких лент на разных пинах, по кадру между
+ * прерываниями.
+ *
+ * Программа измеряет длительность кадра Timer1 (предделитель 8, 0.5 us) и печатает в USART (1 000 000 бод):
+ * светодиодов, время кадра с запретом прерываний (blackout_us) и светодиодов в секунду с учетом паузы WS2812_RESET_US.
+ * Ширину импульсов на PB0 (T0H/T1H в тактах: width_min/width_max) показывает tools/simbench/simbench.py -e ws2812.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/delay.h>
+#include <stdint.h>
+
+#include "usart_polled.h"
+
+#define WS2812_PORT PORTB
+#define WS2812_DDR DDRB
+#define WS2812_PIN PB0
+#define WS2812_LEDS 600
+#define WS2812_RESET_US 60
+
+#if F_CPU != 16000000UL
+#error "ws2812_send() рассчитан на 16 MHz"
+#endif
+
+// Отправляет count байт. Вызывается при запрещенных прерываниях. Такты от фронта бита - в комментариях.
+static inline void ws2812_send(const uint8_t *data, uint8_t count, uint8_t high, uint8_t low) {
+    uint8_t byte, bits, next;
+    __asm__ __volatile__(
+        "1:                      \n\t"
+        "ld   %[byte], %a[data]+ \n\t" // 2  загрузка байта продлевает низкий уровень последнего бита
+        "ldi  %[bits], 8         \n\t" // 1
+        "2:                      \n\t"
+        "out  %[port], %[high]   \n\t" // 0  фронт
+        "mov  %[next], %[low]    \n\t" // 1
+        "sbrc %[byte], 7         \n\t" // 2  (пропуск - 2 такта)
+        "mov  %[next], %[high]   \n\t" // 3
+        "nop                     \n\t" // 4
+        "nop                     \n\t" // 5
+        "out  %[port], %[next]   \n\t" // 6  спад для "0"
+        "lsl  %[byte]            \n\t" // 7
+        "nop                     \n\t" // 8
+        "nop                     \n\t" // 9
+        "nop                     \n\t" // 10
+        "nop                     \n\t" // 11
+        "nop                     \n\t" // 12
+        "out  %[port], %[low]    \n\t" // 13 спад для "1"
+        "nop                     \n\t" // 14
+        "nop                     \n\t" // 15
+        "nop                     \n\t" // 16
+        "dec  %[bits]            \n\t" // 17
+        "brne 2b                 \n\t" // 18 (переход - 2 такта, следующий фронт на 20)
+        "dec  %[count]           \n\t" // 19
+        "brne 1b                 \n\t" // 20 (+5 тактов низкого уровня после байта)
+        : [data] "+e" (data), [count] "+r" (count),
+          [byte] "=&r" (byte), [bits] "=&d" (bits), [next] "=&r" (next)
+        : [port] "I" (_SFR_IO_ADDR(WS2812_PORT)), [high] "r" (high), [low] "r" (low)
+        : "memory"
+    );
+}
+
+// --- Палитра ---
+
+typedef struct {
+    uint8_t g, r, b; // Порядок передачи WS2812
+} ws2812_color_t;
+
+ws2812_color_t ws2812_palette[16];
+
+// Цвет палитры из RGB с общей яркостью 0..255 (полная яркость 600 светодиодов - 36 A)
+void ws2812_set_color(uint8_t index, uint8_t r, uint8_t g, uint8_t b, uint8_t brightness) {
+    ws2812_palette[index] = (ws2812_color_t){
+        .g = ((uint16_t)g * brightness) >> 8,
+        .r = ((uint16_t)r * brightness) >> 8,
+        .b = ((uint16_t)b * brightness) >> 8,
+    };
+}
+
+// --- Кадры ---
+
+uint8_t ws2812_pixels[(WS2812_LEDS + 1) / 2]; // 4 бита на светодиод: младшая тетрада - четный светодиод
+
+static inline void ws2812_set_pixel(uint16_t led, uint8_t index) {
+    uint8_t *cell = &ws2812_pixels[led >> 1];
+    *cell = (led & 1) ? (*cell & 0x0F) | (index << 4) : (*cell & 0xF0) | (index & 0x0F);
+}
+
+static inline void ws2812_latch(void) {
+    _delay_us(WS2812_RESET_US);
+}
+
+// Кадр из буфера с палитрой. Прерывания запрещены на все время кадра.
+void ws2812_show_indexed(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t high = WS2812_PORT | (1<<WS2812_PIN); // Остальные пины порта не меняются до конца кадра
+    uint8_t low = WS2812_PORT & ~(1<<WS2812_PIN);
+    const uint8_t *cell = ws2812_pixels;
+    for (uint16_t led = 0; led < WS2812_LEDS; led += 2) {
+        uint8_t pair = *cell++;
+        ws2812_send(&ws2812_palette[pair & 0x0F].g, 3, high, low);
+        if (led + 1 < WS2812_LEDS) {
+            ws2812_send(&ws2812_palette[pair >> 4].g, 3, high, low);
+        }
+    }
+    SREG = sreg;
+    ws2812_latch();
+}
+
+typedef struct {
+    uint8_t length; // 1..255 светодиодов
+    uint8_t index; // Цвет палитры
+} ws2812_run_t;
+
+// Кадр из серий во flash (runs - в PROGMEM). Светодиоды после последней серии не меняются.
+void ws2812_show_rle(const ws2812_run_t *runs, uint8_t count) {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t high = WS2812_PORT | (1<<WS2812_PIN); // Остальные пины порта не меняются до конца кадра
+    uint8_t low = WS2812_PORT & ~(1<<WS2812_PIN);
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t length = pgm_read_byte(&runs[i].length);
+        const uint8_t *color = &ws2812_palette[pgm_read_byte(&runs[i].index) & 0x0F].g;
+        do {
+            ws2812_send(color, 3, high, low);
+        } while (--length);
+    }
+    SREG = sreg;
+    ws2812_latch();
+}
+
+// ticks - время кадра по Timer1 (0.5 us на тик, до 32 ms)
+void print_report(uint16_t leds, uint16_t ticks) {
+    uint32_t blackout_us = ticks / 2;
+    usart_print_blocking("leds=");
+    usart_print_uint_blocking(leds);
+    usart_print_blocking(" blackout_us=");
+    usart_print_uint_blocking(blackout_us);
+    usart_print_blocking(" leds_per_s=");
+    usart_print_uint_blocking((uint32_t)leds * 1000000UL / (blackout_us + WS2812_RESET_US));
+    usart_print_blocking("\r\n");
+}
+
+// Флаг из серий: 200 белых, 200 синих, 200 красных (6 байт flash вместо 1800 байт)
+const ws2812_run_t FLAG[] PROGMEM = {
+    {200, 1}, {200, 2}, {200, 3},
+};
+
+int main(void) {
+    WS2812_DDR |= (1<<WS2812_PIN);
+    usart_init(false);
+    TCCR1B = (1<<CS11); // Timer1 для измерения: предделитель 8
+
+    // Радуга из 8 цветов (индексы 8..15), 0..3 - для флага
+    ws2812_set_color(0, 0, 0, 0, 0);
+    ws2812_set_color(1, 255, 255, 255, 32);
+    ws2812_set_color(2, 0, 0, 255, 32);
+    ws2812_set_color(3, 255, 0, 0, 32);
+    for (uint16_t led = 0; led < WS2812_LEDS; led++) {
+        ws2812_set_pixel(led, 8 + (led / 8) % 8);
+    }
+    const uint8_t rainbow[8][3] = {
+        {255, 0, 0}, {255, 128, 0}, {255, 255, 0}, {0, 255, 0},
+        {0, 255, 255}, {0, 0, 255}, {128, 0, 255}, {255, 0, 128},
+    };
+
+    sei();
+
+    uint8_t phase = 0;
+    while (1) {
+        // 200 кадров радуги, бегущей за счет сдвига палитры
+        for (uint8_t frame = 0; frame < 200; frame++) {
+            for (uint8_t i = 0; i < 8; i++) {
+                const uint8_t *rgb = rainbow[(i + phase) & 7];
+                ws2812_set_color(8 + i, rgb[0], rgb[1], rgb[2], 32);
+            }
+            phase++;
+
+            uint16_t start = TCNT1;
+            ws2812_show_indexed();
+            uint16_t ticks = TCNT1 - start - WS2812_RESET_US * 2;
+            if (frame == 0) {
+                print_report(WS2812_LEDS, ticks);
+            }
+        }
+
+        uint16_t start = TCNT1;
+        ws2812_show_rle(FLAG, sizeof(FLAG) / sizeof(FLAG[0]));
+        uint16_t ticks = TCNT1 - start - WS2812_RESET_US * 2;
+        print_report(WS2812_LEDS, ticks);
+        _delay_ms(2000);
+    }
+}
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+Декодер журнала АЦП из src/main-adc-logger.c.
+
+Читает дамп (файл или последовательный порт), распаковывает страницы и печатает отсчеты:
+номер сеанса (запуска платы), время от начала сеанса, значение АЦП и напряжение (опорное 5 V).
+В конце - степень сжатия: байт в журнале против 2 байт на отсчет.
+
+Формат страницы: первый отсчет (uint16), число отсчетов (uint8), номер сеанса (uint8), затем разности
+с предыдущим отсчетом в zig-zag, тетрадами по 3 бита данных (младшие первыми, бит 3 - продолжение),
+в байте сначала младшая тетрада.
+
+Примеры:
+  # Запросить дамп у платы и декодировать (нужен pyserial: pip install pyserial)
+  python3 tools/adc_log_decode.py --port /dev/ttyUSB0
+
+  # Сохранить дамп в файл и декодировать позже
+  python3 tools/adc_log_decode.py --port /dev/ttyUSB0 --save log.bin
+  python3 tools/adc_log_decode.py log.bin --csv > log.csv
+
+Открытие порта на Arduino Nano обычно сбрасывает плату: линия DTR через конденсатор подключена к RESET.
+Порт открывается с выключенным DTR, но часть драйверов все равно выставляет его при открытии. Поэтому после
+открытия декодер ждет RESET_WAIT_S, пока загрузчик не передаст управление программе, и только потом отправляет 'd'
+(иначе символ получил бы загрузчик). Если плата сбросилась, незаполненная страница из RAM потеряна
+(в дампе только страницы EEPROM), а новые отсчеты идут в следующий сеанс.
+Чтобы получить и страницу из RAM, отключите автосброс (конденсатор 10 uF между RESET и GND на время дампа)
+или отправьте 'd' из терминала, который уже открыт.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+MAGIC = b"ADL\x01"
+HEADER = struct.Struct("<4sHBB")  # magic, period_ms, page_size, pages
+PAGE_HEADER = struct.Struct("<HBB")  # first, count, session
+PAGE_EMPTY = 0xFF
+VREF = 5.0
+RESET_WAIT_S = 2.0  # Загрузчик optiboot ждет ~1 s после сброса
+
+
+def read_dump(stream):
+    """Ищет заголовок в потоке и возвращает (period_ms, page_size, [страница, ...])."""
+    window = b""
+    while window != MAGIC:
+        byte = stream.read(1)
+        if not byte:
+            raise ValueError("log header not found")
+        window = (window + byte)[-len(MAGIC):]
+
+    rest = stream.read(HEADER.size - len(MAGIC))
+    _, period_ms, page_size, count = HEADER.unpack(MAGIC + rest)
+    data = stream.read(count * page_size)
+    if len(data) != count * page_size:
+        raise ValueError("log truncated: expected %d pages, got %d bytes" % (count, len(data)))
+    pages = [data[i * page_size:(i + 1) * page_size] for i in range(count)]
+    return period_ms, page_size, pages
+
+
+def nibbles(data):
+    for byte in data:
+        yield byte & 0x0F
+        yield byte >> 4
+
+
+def decode_page(page):
+    """Возвращает (session, [отсчет, ...]); пустая страница - (session, [])."""
+    first, count, session = PAGE_HEADER.unpack_from(page)
+    if count == 0 or count == PAGE_EMPTY:
+        return session, []
+    samples = [first]
+    stream = nibbles(page[PAGE_HEADER.size:])
+    try:
+        while len(samples) < count:
+            zigzag = 0
+            shift = 0
+            while True:
+                nibble = next(stream)
+                zigzag |= (nibble & 0x07) << shift
+                shift += 3
+                if not nibble & 0x08:
+                    break
+            delta = (zigzag >> 1) ^ -(zigzag & 1)
+            samples.append((samples[-1] + delta) & 0xFFFF)
+    except StopIteration:
+        raise ValueError("page ends after %d of %d samples" % (len(samples), count))
+    return session, samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a delta-encoded ADC log from main-adc-logger.c")
+    parser.add_argument("file", nargs="?", help="dump file (default: stdin)")
+    parser.add_argument("--port", help="serial port, sends 'd' and reads the dump")
+    parser.add_argument("--baud", type=int, default=1000000)
+    parser.add_argument("--save", help="also save the raw dump to this file")
+    parser.add_argument("--csv", action="store_true", help="print CSV instead of a table")
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+
+        port = serial.Serial(baudrate=args.baud, timeout=2)
+        port.port = args.port
+        port.dtr = False  # До open(): иначе DTR сбросит плату
+        port.rts = False
+        port.open()
+        with port:
+            time.sleep(RESET_WAIT_S)  # Если плата все же сбросилась, 'd' должна получить программа, а не загрузчик
+            port.reset_input_buffer()
+            port.write(b"d")
+            period_ms, page_size, pages = read_dump(port)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(HEADER.pack(MAGIC, period_ms, page_size, len(pages)))
+                f.write(b"".join(pages))
+    elif args.file:
+        with open(args.file, "rb") as f:
+            period_ms, page_size, pages = read_dump(f)
+    else:
+        period_ms, page_size, pages = read_dump(sys.stdin.buffer)
+
+    if args.csv:
+        print("session,time_s,adc,volts")
+
+    total = 0
+    used_bytes = 0
+    previous_session = None
+    index = 0
+    for number, page in enumerate(pages):
+        try:
+            session, samples = decode_page(page)
+        except ValueError as error:
+            print("# page %d: %s" % (number, error), file=sys.stderr)
+            continue
+        if not samples:
+            continue
+        if session != previous_session:
+            previous_session = session
+            index = 0
+            if not args.csv:
+                print("# session %d" % session)
+        for sample in samples:
+            time_s = index * period_ms / 1000.0
+            volts = sample * VREF / 1024
+            if args.csv:
+                print("%d,%.3f,%d,%.3f" % (session, time_s, sample, volts))
+            else:
+                print("%10.3f s  %4d  %.3f V" % (time_s, sample, volts))
+            index += 1
+        total += len(samples)
+        used_bytes += len(page)
+
+    # Последняя страница (из RAM) заполнена не целиком, но и в EEPROM заняла бы страницу целиком
+    ratio = total * 2 / used_bytes if used_bytes else 0
+    print("# %d samples in %d pages (%d bytes), raw %d bytes, ratio %.2f"
+          % (total, len(pages), used_bytes, total * 2, ratio), file=sys.stderr if args.csv else sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
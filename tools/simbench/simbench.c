@@ -0,0 +1,253 @@
+/*
+ * Запуск прошивки в симуляторе simavr с подсчетом тактов.
+ *
+ * Сборку и запуск выполняет tools/simbench/simbench.py, вручную:
+ *   cc -O2 -o simbench simbench.c $(pkg-config --cflags --libs simavr)
+ *   ./simbench firmware.elf 2000000 [--loop-pc 0x1a4] [--stimulus stim.txt] [--pulses DB]
+ *
+ * Симулируется ATmega328P на 16 MHz в течение заданного времени (us).
+ * Результат - одна строка JSON в stdout:
+ *  - cycles, sleep_cycles - всего тактов и тактов в режиме сна;
+ *  - isr - для каждого сработавшего вектора: количество, сумма, максимум тактов от входа в вектор до reti;
+ *  - loop_hits - сколько раз выполнена инструкция по адресу --loop-pc (итерации основного цикла);
+ *  - pulses - для каждого пина портов --pulses (например, --pulses DB): количество импульсов высокого уровня
+ *    и их минимальная/максимальная ширина в тактах. Для постоянного сигнала max - min - это дрожание фронтов.
+ *
+ * Файл воздействий (stimulus) - текст, одна строка на событие, время в микросекундах от старта:
+ *   <time_us> pin <порт><бит> <0|1>     например: 1000 pin B0 0
+ *   <time_us> adc <канал> <милливольты> например: 0 adc 5 2500
+ * Строки с # - комментарии.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+#include <simavr/sim_interrupts.h>
+#include <simavr/sim_cycle_timers.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_adc.h>
+
+#define FREQUENCY 16000000UL
+#define VECTORS 26
+#define STIMULI_MAX 4096
+
+typedef struct {
+    uint64_t count;
+    uint64_t cycles;
+    uint64_t cycles_max;
+    avr_cycle_count_t start;
+} isr_stats_t;
+
+typedef struct {
+    avr_cycle_count_t cycle;
+    char kind; // 'p' - пин, 'a' - АЦП
+    char port;
+    uint8_t index;
+    uint32_t value;
+} stimulus_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t width_min;
+    uint64_t width_max;
+    avr_cycle_count_t rise;
+    uint8_t level;
+} pulse_stats_t;
+
+static avr_t *avr;
+static const char *pulse_ports = "";
+static pulse_stats_t pulse_stats[4][8]; // Порты B, C, D (индекс - буква - 'A')
+static isr_stats_t isr_stats[VECTORS];
+static stimulus_t stimuli[STIMULI_MAX];
+static size_t stimuli_count;
+static size_t stimuli_next;
+
+static void on_isr_running(struct avr_irq_t *irq, uint32_t value, void *param) {
+    isr_stats_t *stats = &isr_stats[(uintptr_t)param];
+    if (value) {
+        stats->start = avr->cycle;
+    } else if (stats->start) {
+        uint64_t cycles = avr->cycle - stats->start;
+        stats->count++;
+        stats->cycles += cycles;
+        if (cycles > stats->cycles_max) {
+            stats->cycles_max = cycles;
+        }
+        stats->start = 0;
+    }
+}
+
+static void on_pin_change(struct avr_irq_t *irq, uint32_t value, void *param) {
+    pulse_stats_t *stats = param;
+    if (value && !stats->level) {
+        stats->rise = avr->cycle;
+    } else if (!value && stats->level && stats->rise) {
+        uint64_t width = avr->cycle - stats->rise;
+        if (!stats->count || width < stats->width_min) {
+            stats->width_min = width;
+        }
+        if (width > stats->width_max) {
+            stats->width_max = width;
+        }
+        stats->count++;
+    }
+    stats->level = value != 0;
+}
+
+static void apply_stimulus(const stimulus_t *stimulus) {
+    if (stimulus->kind == 'p') {
+        avr_irq_t *irq = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(stimulus->port), stimulus->index);
+        avr_raise_irq(irq, stimulus->value);
+    } else {
+        avr_irq_t *irq = avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + stimulus->index);
+        avr_raise_irq(irq, stimulus->value);
+    }
+}
+
+// Таймер simavr вызывается точно в заданный такт, в том числе во время сна
+static avr_cycle_count_t on_stimulus_timer(avr_t *avr_, avr_cycle_count_t when, void *param) {
+    while (stimuli_next < stimuli_count && stimuli[stimuli_next].cycle <= when) {
+        apply_stimulus(&stimuli[stimuli_next++]);
+    }
+    return stimuli_next < stimuli_count ? stimuli[stimuli_next].cycle : 0;
+}
+
+static int compare_stimuli(const void *a, const void *b) {
+    const stimulus_t *sa = a, *sb = b;
+    return sa->cycle < sb->cycle ? -1 : sa->cycle > sb->cycle;
+}
+
+static void load_stimuli(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(2);
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), file) && stimuli_count < STIMULI_MAX) {
+        double time_us;
+        char kind[8], target[8];
+        unsigned value;
+        if (line[0] == '#' || sscanf(line, "%lf %7s %7s %u", &time_us, kind, target, &value) != 4) {
+            continue;
+        }
+        stimulus_t *stimulus = &stimuli[stimuli_count++];
+        stimulus->cycle = (avr_cycle_count_t)(time_us * (FREQUENCY / 1000000));
+        stimulus->value = value;
+        if (strcmp(kind, "pin") == 0) {
+            stimulus->kind = 'p';
+            stimulus->port = target[0];
+            stimulus->index = atoi(target + 1);
+        } else {
+            stimulus->kind = 'a';
+            stimulus->index = atoi(target);
+        }
+    }
+    fclose(file);
+    qsort(stimuli, stimuli_count, sizeof(stimulus_t), compare_stimuli);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s firmware.elf duration_us [--loop-pc ADDR] [--stimulus FILE] [--pulses PORTS]\n", argv[0]);
+        return 2;
+    }
+    const char *elf_path = argv[1];
+    uint64_t duration_cycles = strtoull(argv[2], NULL, 0) * (FREQUENCY / 1000000);
+    long loop_pc = -1;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--loop-pc") == 0) {
+            loop_pc = strtol(argv[i + 1], NULL, 0);
+        } else if (strcmp(argv[i], "--stimulus") == 0) {
+            load_stimuli(argv[i + 1]);
+        } else if (strcmp(argv[i], "--pulses") == 0) {
+            pulse_ports = argv[i + 1];
+        }
+    }
+
+    elf_firmware_t firmware = {0};
+    if (elf_read_firmware(elf_path, &firmware) != 0) {
+        fprintf(stderr, "cannot read %s\n", elf_path);
+        return 2;
+    }
+    avr = avr_make_mcu_by_name("atmega328p");
+    if (!avr) {
+        fprintf(stderr, "simavr has no atmega328p core\n");
+        return 2;
+    }
+    avr_init(avr);
+    firmware.frequency = FREQUENCY;
+    avr_load_firmware(avr, &firmware);
+    avr->log = LOG_NONE;
+
+    for (uintptr_t vector = 1; vector < VECTORS; vector++) {
+        avr_irq_t *irq = avr_get_interrupt_irq(avr, vector);
+        if (irq) {
+            avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, on_isr_running, (void *)vector);
+        }
+    }
+    for (const char *port = pulse_ports; *port; port++) {
+        if (*port < 'B' || *port > 'D') {
+            continue;
+        }
+        for (int pin = 0; pin < 8; pin++) {
+            avr_irq_t *irq = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(*port), pin);
+            if (irq) {
+                avr_irq_register_notify(irq, on_pin_change, &pulse_stats[*port - 'A'][pin]);
+            }
+        }
+    }
+    if (stimuli_count) {
+        avr_cycle_timer_register(avr, stimuli[0].cycle + 1, on_stimulus_timer, NULL);
+    }
+
+    uint64_t sleep_cycles = 0;
+    uint64_t loop_hits = 0;
+    int state = cpu_Running;
+
+    while (avr->cycle < duration_cycles && state != cpu_Done && state != cpu_Crashed) {
+        avr_cycle_count_t before = avr->cycle;
+        int was_sleeping = avr->state == cpu_Sleeping;
+        state = avr_run(avr);
+        if (was_sleeping) {
+            sleep_cycles += avr->cycle - before;
+        }
+        if (avr->pc == (avr_flashaddr_t)loop_pc) {
+            loop_hits++;
+        }
+    }
+
+    printf("{\"cycles\": %" PRIu64 ", \"sleep_cycles\": %" PRIu64 ", \"loop_hits\": %" PRIu64 ", \"crashed\": %s, \"isr\": {",
+           (uint64_t)avr->cycle, sleep_cycles, loop_hits, state == cpu_Crashed ? "true" : "false");
+    const char *separator = "";
+    for (int vector = 1; vector < VECTORS; vector++) {
+        isr_stats_t *stats = &isr_stats[vector];
+        if (stats->count) {
+            printf("%s\"%d\": {\"count\": %" PRIu64 ", \"cycles\": %" PRIu64 ", \"cycles_max\": %" PRIu64 "}",
+                   separator, vector, stats->count, stats->cycles, stats->cycles_max);
+            separator = ", ";
+        }
+    }
+    printf("}, \"pulses\": {");
+    separator = "";
+    for (const char *port = pulse_ports; *port; port++) {
+        if (*port < 'B' || *port > 'D') {
+            continue;
+        }
+        for (int pin = 0; pin < 8; pin++) {
+            pulse_stats_t *stats = &pulse_stats[*port - 'A'][pin];
+            if (stats->count) {
+                printf("%s\"%c%d\": {\"count\": %" PRIu64 ", \"width_min\": %" PRIu64 ", \"width_max\": %" PRIu64 "}",
+                       separator, *port, pin, stats->count, stats->width_min, stats->width_max);
+                separator = ", ";
+            }
+        }
+    }
+    printf("}}\n");
+    return 0;
+}
@@ -0,0 +1,353 @@
+#!/usr/bin/env python3
+"""
+Бенчмарк всех окружений platformio.ini в симуляторе simavr (без платы).
+
+Для каждого окружения:
+  - собирает прошивку (pio run -e <env>);
+  - берет размер flash/RAM из avr-size;
+  - запускает прошивку в simavr (tools/simbench/simbench.c) на заданное время с воздействиями:
+    ИК-посылка NEC на ICP1, значения АЦП, нажатия кнопок с дребезгом, сигнал энкодера;
+  - считает такты каждого обработчика прерывания, долю времени во сне и частоту основного цикла;
+    начало итерации находится по дизассемблеру main (avr-objdump -d): цель последнего внешнего перехода
+    назад (rjmp/jmp/br*, чей диапазон не вложен в диапазон другого перехода) - это голова while (1),
+    включая event_loop_run(), встроенный в main. Циклы настройки перед основным циклом стоят раньше,
+    вложенные циклы итерации - внутри его диапазона. Если основной цикл не в main (функция не встроилась),
+    адрес задается символом loop_symbol;
+  - для окружений с выходными импульсами (pulses) - ширину импульсов каждого пина и дрожание (max - min, такты);
+    пины, где ширину меняет сама программа (moving_pins), в дрожание не входят.
+
+Результаты сохраняются в .pio/simbench/results.json и сравниваются с tools/simbench/baseline.json.
+Ухудшение любой метрики больше допуска (--tolerance, по умолчанию 5%) - это регрессия, код возврата 1.
+
+Требования (Linux): simavr с заголовками (libsimavr-dev / simavr-devel), libelf, pkg-config, PlatformIO.
+
+Примеры:
+  python3 tools/simbench/simbench.py                    # все окружения, сравнить с baseline
+  python3 tools/simbench/simbench.py -e ir-receiver adc # только указанные окружения
+  python3 tools/simbench/simbench.py --update-baseline  # записать текущие результаты как baseline
+"""
+
+import argparse
+import configparser
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+HERE = os.path.dirname(os.path.abspath(__file__))
+WORK = os.path.join(ROOT, ".pio", "simbench")
+BASELINE = os.path.join(HERE, "baseline.json")
+FREQUENCY = 16000000
+
+VECTORS = {
+    1: "INT0", 2: "INT1", 3: "PCINT0", 4: "PCINT1", 5: "PCINT2", 6: "WDT",
+    7: "TIMER2_COMPA", 8: "TIMER2_COMPB", 9: "TIMER2_OVF", 10: "TIMER1_CAPT",
+    11: "TIMER1_COMPA", 12: "TIMER1_COMPB", 13: "TIMER1_OVF", 14: "TIMER0_COMPA",
+    15: "TIMER0_COMPB", 16: "TIMER0_OVF", 17: "SPI_STC", 18: "USART_RX",
+    19: "USART_UDRE", 20: "USART_TX", 21: "ADC", 22: "EE_READY",
+    23: "ANALOG_COMP", 24: "TWI", 25: "SPM_READY",
+}
+
+
+# --- Воздействия: списки (time_us, "pin"|"adc", target, value) ---
+
+def nec_frame(start_us, address=0x00, command=0x45, pin="B0"):
+    """Выход TSOP4838 (инвертированный): LOW - импульс, HIGH - пауза."""
+    events = [(0, "pin", pin, 1)]
+    t = start_us
+
+    def pulse(low_us, high_us):
+        nonlocal t
+        events.append((t, "pin", pin, 0))
+        t += low_us
+        events.append((t, "pin", pin, 1))
+        t += high_us
+
+    pulse(9000, 4500)
+    data = address | ((~address & 0xFF) << 8) | (command << 16) | ((~command & 0xFF) << 24)
+    for bit in range(32):
+        pulse(562.5, 1687.5 if (data >> bit) & 1 else 562.5)
+    pulse(562.5, 0)
+    return events
+
+
+def button_press(start_us, pin, hold_us=50000, bounces=5):
+    """Нажатие кнопки на GND с дребезгом 0.2 ms на каждом фронте."""
+    events = [(0, "pin", pin, 1)]
+    for edge_start, level in ((start_us, 0), (start_us + hold_us, 1)):
+        t = edge_start
+        for _ in range(bounces):
+            events.append((t, "pin", pin, level))
+            events.append((t + 100, "pin", pin, 1 - level))
+            t += 200
+        events.append((t, "pin", pin, level))
+    return events
+
+
+def adc_ramp(channel=5, steps=10, period_us=100000):
+    return [(i * period_us, "adc", str(channel), i * 5000 // steps) for i in range(steps)]
+
+
+def quadrature(start_us, edges, edge_period_us, pin_a="C0", pin_b="C1"):
+    events = [(0, "pin", pin_a, 1), (0, "pin", pin_b, 1)]
+    a, b = 1, 1
+    for i in range(edges):
+        if i % 2 == 0:
+            a ^= 1
+            events.append((start_us + i * edge_period_us, "pin", pin_a, a))
+        else:
+            b ^= 1
+            events.append((start_us + i * edge_period_us, "pin", pin_b, b))
+    return events
+
+
+def serial_idle():
+    return [(0, "pin", "D0", 1)]  # Линия RX в покое
+
+
+# Настройки окружений: время симуляции, воздействия, loop_symbol - символ начала основного цикла, если он не в main
+ENVS = {
+    "external-interrupt": {"stimulus": button_press(200000, "D2")},
+    "external-interrupt-pin-change": {"stimulus": button_press(200000, "B0")},
+    "sleep": {"stimulus": button_press(200000, "D2")},
+    "adc": {"stimulus": adc_ramp()},
+    "ir-receiver": {"stimulus": nec_frame(100000)},
+    "power-manager": {"stimulus": adc_ramp() + button_press(200000, "D2")},
+    "clock-scaling": {"stimulus": nec_frame(100000)},
+    "button-debounce": {"stimulus": button_press(200000, "D2") + button_press(500000, "D7")},
+    "pin-change-dispatcher": {
+        "stimulus": button_press(200000, "D2") + button_press(400000, "C0") + button_press(600000, "B0"),
+    },
+    "rotary-encoder": {"stimulus": quadrature(100000, 4000, 25)},  # 40 000 фронтов в секунду
+    "usart": {"stimulus": serial_idle() + adc_ramp()},
+    "trace": {"stimulus": serial_idle() + nec_frame(100000)},
+    "isr-profiler": {"stimulus": serial_idle() + nec_frame(100000)},
+    "servo": {"pulses": "DB", "moving_pins": ["D2"]},  # Сервопривод 0 (D2) ходит от края до края
+    "ws2812": {"pulses": "B", "moving_pins": ["B0"]},  # width_min/width_max на B0 - T0H/T1H в тактах, не дрожание
+    "adc-logger": {"stimulus": serial_idle() + adc_ramp()},
+    "wake-latency": {"duration_us": 8000000},  # 6 режимов по 16 замеров из 4 периодов WDT
+}
+
+DEFAULT_DURATION_US = 1000000
+
+
+def env_names():
+    config = configparser.ConfigParser(inline_comment_prefixes=(";", "#"), comment_prefixes=(";", "#"))
+    config.read(os.path.join(ROOT, "platformio.ini"))
+    # Окружения native-* собираются для компьютера (lib/hal_native), в simavr их не запустить
+    return [section[4:] for section in config.sections()
+            if section.startswith("env:") and config.get(section, "extends", fallback="") != "native"]
+
+
+def tool(name):
+    """Ищет утилиту avr-* в PATH или в toolchain PlatformIO."""
+    path = shutil.which(name)
+    if path:
+        return path
+    candidate = os.path.expanduser(os.path.join("~", ".platformio", "packages", "toolchain-atmelavr", "bin", name))
+    if os.path.exists(candidate):
+        return candidate
+    sys.exit("%s not found (install avr-binutils or build once with PlatformIO)" % name)
+
+
+def build_harness():
+    os.makedirs(WORK, exist_ok=True)
+    binary = os.path.join(WORK, "simbench")
+    source = os.path.join(HERE, "simbench.c")
+    if os.path.exists(binary) and os.path.getmtime(binary) > os.path.getmtime(source):
+        return binary
+    try:
+        flags = subprocess.check_output(["pkg-config", "--cflags", "--libs", "simavr"], text=True).split()
+    except (OSError, subprocess.CalledProcessError):
+        flags = ["-I/usr/include/simavr", "-lsimavr", "-lelf"]
+    subprocess.check_call(["cc", "-O2", "-o", binary, source] + flags)
+    return binary
+
+
+def firmware_size(elf):
+    """flash = .text + .data, ram = .data + .bss (как в отчете PlatformIO)."""
+    output = subprocess.check_output([tool("avr-size"), "-A", elf], text=True)
+    sections = {}
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+            sections[parts[0]] = int(parts[1])
+    return {
+        "flash": sections.get(".text", 0) + sections.get(".data", 0),
+        "ram": sections.get(".data", 0) + sections.get(".bss", 0),
+    }
+
+
+def symbol_address(elf, name):
+    output = subprocess.check_output([tool("avr-nm"), elf], text=True)
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[2] == name:
+            return int(parts[0], 16)
+    return None
+
+
+JUMP = re.compile(r"^\s*([0-9a-f]+):\s+(?:[0-9a-f]{2} )+\s*(rjmp|jmp|br[a-z]+)\s+(\S+)(?:\s*;\s*0x([0-9a-f]+))?")
+
+
+def main_loop_address(elf):
+    """Адрес головы основного цикла в main: цель последнего перехода назад, не вложенного в другой."""
+    output = subprocess.check_output([tool("avr-nm"), "-S", elf], text=True)
+    start = None
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) == 4 and parts[3] == "main":
+            start, size = int(parts[0], 16), int(parts[1], 16)
+    if start is None:
+        return None
+    output = subprocess.check_output([tool("avr-objdump"), "-d", "--start-address=0x%x" % start,
+                                      "--stop-address=0x%x" % (start + size), elf], text=True)
+    loops = []  # (цель, адрес перехода)
+    for line in output.splitlines():
+        match = JUMP.match(line)
+        if not match:
+            continue
+        address = int(match.group(1), 16)
+        # Для rjmp и br* абсолютный адрес - в комментарии objdump, у jmp - в операнде
+        target = int(match.group(4), 16) if match.group(4) else int(match.group(3), 0)
+        if start <= target <= address:
+            loops.append((target, address))
+    outer = [(target, address) for target, address in loops
+             if not any(t <= target and address <= a and (t, a) != (target, address) for t, a in loops)]
+    return max(outer, key=lambda loop: loop[1])[0] if outer else None
+
+
+def run_env(env, harness, build):
+    settings = ENVS.get(env, {})
+    if build:
+        subprocess.check_call(["pio", "run", "-s", "-e", env], cwd=ROOT)
+    elf = os.path.join(ROOT, ".pio", "build", env, "firmware.elf")
+    duration_us = settings.get("duration_us", DEFAULT_DURATION_US)
+
+    command = [harness, elf, str(duration_us)]
+    stimulus = settings.get("stimulus")
+    if stimulus:
+        path = os.path.join(WORK, env + ".stim")
+        with open(path, "w") as f:
+            for time_us, kind, target, value in sorted(stimulus, key=lambda e: e[0]):
+                f.write("%s %s %s %d\n" % (time_us, kind, target, value))
+        command += ["--stimulus", path]
+    loop_pc = symbol_address(elf, settings["loop_symbol"]) if "loop_symbol" in settings else main_loop_address(elf)
+    if loop_pc is not None:
+        command += ["--loop-pc", hex(loop_pc)]
+    if "pulses" in settings:
+        command += ["--pulses", settings["pulses"]]
+
+    raw = json.loads(subprocess.check_output(command, text=True))
+    cycles = raw["cycles"]
+    seconds = cycles / FREQUENCY
+    result = firmware_size(elf)
+    result.update({
+        "simulated_ms": round(seconds * 1000, 3),
+        "crashed": raw["crashed"],
+        "active_percent": round(100.0 * (cycles - raw["sleep_cycles"]) / cycles, 2) if cycles else 0.0,
+        "loop_rate_hz": round(raw["loop_hits"] / seconds, 1) if loop_pc is not None and seconds else None,
+        "isr": {},
+        "pulses": {},
+    })
+    for vector, stats in raw["isr"].items():
+        result["isr"][VECTORS.get(int(vector), vector)] = {
+            "count": stats["count"],
+            "cycles_avg": round(stats["cycles"] / stats["count"], 1),
+            "cycles_max": stats["cycles_max"],
+        }
+    for pin, stats in raw.get("pulses", {}).items():
+        # У пинов moving_pins ширина импульса меняется программой: max - min - это движение, а не дрожание
+        jitter = None if pin in settings.get("moving_pins", ()) else stats["width_max"] - stats["width_min"]
+        result["pulses"][pin] = dict(stats, jitter=jitter)
+    return result
+
+
+def compare(results, baseline, tolerance):
+    """Возвращает список регрессий: метрика выросла (или частота цикла упала) больше допуска."""
+    regressions = []
+
+    def check(env, name, new, old, higher_is_worse=True):
+        if new is None or old is None or old == 0:
+            return
+        change = (new - old) / old if higher_is_worse else (old - new) / old
+        if change > tolerance:
+            regressions.append("%s: %s %s -> %s (%+.1f%%)" % (env, name, old, new, change * 100))
+
+    for env, new in results.items():
+        old = baseline.get(env)
+        if not old:
+            continue
+        for metric in ("flash", "ram", "active_percent"):
+            check(env, metric, new.get(metric), old.get(metric))
+        check(env, "loop_rate_hz", new.get("loop_rate_hz"), old.get("loop_rate_hz"), higher_is_worse=False)
+        for vector, stats in new["isr"].items():
+            old_stats = old.get("isr", {}).get(vector)
+            if old_stats:
+                check(env, vector + ".cycles_avg", stats["cycles_avg"], old_stats["cycles_avg"])
+                check(env, vector + ".cycles_max", stats["cycles_max"], old_stats["cycles_max"])
+        for pin, stats in new.get("pulses", {}).items():
+            old_stats = old.get("pulses", {}).get(pin)
+            if old_stats:
+                check(env, pin + ".jitter", stats["jitter"], old_stats["jitter"])
+    return regressions
+
+
+def print_table(results):
+    print("%-32s %6s %5s %8s %10s  %s" % ("env", "flash", "ram", "active%", "loop Hz", "isr: count x avg/max cycles"))
+    for env, r in results.items():
+        isr = ", ".join("%s %dx%.0f/%d" % (name, s["count"], s["cycles_avg"], s["cycles_max"]) for name, s in r["isr"].items())
+        loop = "%.0f" % r["loop_rate_hz"] if r["loop_rate_hz"] is not None else "-"
+        jitters = [s["jitter"] for s in r["pulses"].values() if s["jitter"] is not None]
+        if jitters:
+            isr += "; pulse jitter max %d cycles" % max(jitters)
+        print("%-32s %6d %5d %8.2f %10s  %s%s" % (
+            env, r["flash"], r["ram"], r["active_percent"], loop, isr, "  CRASHED" if r["crashed"] else ""))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Cycle-accurate simavr benchmark for every PlatformIO environment")
+    parser.add_argument("-e", "--env", nargs="*", help="environments (default: all from platformio.ini)")
+    parser.add_argument("--no-build", action="store_true", help="use existing .pio/build/<env>/firmware.elf")
+    parser.add_argument("--tolerance", type=float, default=0.05, help="allowed relative regression (default 0.05)")
+    parser.add_argument("--update-baseline", action="store_true", help="write results to tools/simbench/baseline.json")
+    args = parser.parse_args()
+
+    harness = build_harness()
+    envs = args.env or env_names()
+    results = {}
+    for env in envs:
+        results[env] = run_env(env, harness, not args.no_build)
+
+    with open(os.path.join(WORK, "results.json"), "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print_table(results)
+
+    if args.update_baseline:
+        baseline = {}
+        if os.path.exists(BASELINE):
+            with open(BASELINE) as f:
+                baseline = json.load(f)
+        baseline.update(results)
+        with open(BASELINE, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline updated: %s" % os.path.relpath(BASELINE, ROOT))
+        return 0
+
+    if not os.path.exists(BASELINE):
+        print("no baseline yet, run with --update-baseline")
+        return 0
+    with open(BASELINE) as f:
+        regressions = compare(results, json.load(f), args.tolerance)
+    for line in regressions:
+        print("REGRESSION " + line)
+    crashed = [env for env, r in results.items() if r["crashed"]]
+    return 1 if regressions or crashed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
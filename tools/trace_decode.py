@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Декодер трассы событий из src/main-trace.c.
+
+Читает двоичный дамп (файл или последовательный порт) и печатает шкалу времени:
+время от первого события, интервал от предыдущего события, имя события и данные.
+
+Примеры:
+  # Запросить дамп у платы и декодировать (нужен pyserial: pip install pyserial)
+  python3 tools/trace_decode.py --port /dev/ttyUSB0
+
+  # Сохранить дамп в файл и декодировать позже
+  python3 tools/trace_decode.py --port /dev/ttyUSB0 --save trace.bin
+  python3 tools/trace_decode.py trace.bin --csv > trace.csv
+
+Трасса хранится только в RAM, а открытие порта с DTR сбрасывает Arduino Nano, поэтому порт открывается
+с выключенными DTR/RTS. Если драйвер все же сбрасывает плату, трасса потеряна: отключите автосброс
+(конденсатор 10 uF между RESET и GND) или отправьте 'd' из уже открытого терминала с записью в файл.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"TRC\x01"
+HEADER = struct.Struct("<4sHHI")  # magic, tick_ns, count, total
+RECORD = struct.Struct("<BBH")  # id, payload, timestamp
+
+# Номера событий из src/main-trace.c (TRACE_*)
+EVENTS = {
+    1: "tick",
+    2: "ir_edge",
+    3: "ir_error",
+    4: "ir_command",
+    5: "dump",
+}
+
+
+def read_dump(stream):
+    """Ищет заголовок в потоке и возвращает (tick_ns, total, [(id, payload, timestamp), ...])."""
+    window = b""
+    while window != MAGIC:
+        byte = stream.read(1)
+        if not byte:
+            raise ValueError("trace header not found")
+        window = (window + byte)[-len(MAGIC):]
+
+    rest = stream.read(HEADER.size - len(MAGIC))
+    _, tick_ns, count, total = HEADER.unpack(MAGIC + rest)
+    data = stream.read(count * RECORD.size)
+    if len(data) != count * RECORD.size:
+        raise ValueError("trace truncated: expected %d records, got %d bytes" % (count, len(data)))
+    records = [RECORD.unpack_from(data, i * RECORD.size) for i in range(count)]
+    return tick_ns, total, records
+
+
+def unwrap(records):
+    """Переводит 16-битные метки времени в непрерывные (между соседними событиями меньше одного переполнения)."""
+    ticks = 0
+    previous = None
+    for event_id, payload, timestamp in records:
+        if previous is not None:
+            ticks += (timestamp - previous) & 0xFFFF
+        previous = timestamp
+        yield ticks, event_id, payload
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a binary event trace from main-trace.c")
+    parser.add_argument("file", nargs="?", help="dump file (default: stdin)")
+    parser.add_argument("--port", help="serial port, sends 'd' and reads the dump")
+    parser.add_argument("--baud", type=int, default=1000000)
+    parser.add_argument("--save", help="also save the raw dump to this file")
+    parser.add_argument("--csv", action="store_true", help="print CSV instead of a text timeline")
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+
+        port = serial.Serial(baudrate=args.baud, timeout=2)
+        port.port = args.port
+        port.dtr = False  # До open(): иначе DTR сбросит плату и сотрет трассу
+        port.rts = False
+        port.open()
+        with port:
+            port.reset_input_buffer()
+            port.write(b"d")
+            tick_ns, total, records = read_dump(port)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(HEADER.pack(MAGIC, tick_ns, len(records), total))
+                f.write(b"".join(RECORD.pack(*r) for r in records))
+    elif args.file:
+        with open(args.file, "rb") as f:
+            tick_ns, total, records = read_dump(f)
+    else:
+        tick_ns, total, records = read_dump(sys.stdin.buffer)
+
+    if args.csv:
+        print("time_us,delta_us,event,payload")
+    else:
+        print("# %d events, %d lost (ring overwritten), tick %d ns" % (len(records), total - len(records), tick_ns))
+
+    previous_us = 0.0
+    for ticks, event_id, payload in unwrap(records):
+        time_us = ticks * tick_ns / 1000.0
+        delta_us = time_us - previous_us
+        previous_us = time_us
+        name = EVENTS.get(event_id, "event_%d" % event_id)
+        if args.csv:
+            print("%.1f,%.1f,%s,%d" % (time_us, delta_us, name, payload))
+        else:
+            print("%12.1f us  %+10.1f us  %-12s %3d (0x%02X)" % (time_us, delta_us, name, payload, payload))
+
+
+if __name__ == "__main__":
+    main()